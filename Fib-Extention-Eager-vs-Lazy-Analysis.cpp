@@ -1,22 +1,63 @@
 #include <iostream>
 #include <vector>
 #include <climits>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <iterator>
+#include <string>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include "slab-pool.h"
+#include "min-slot.h"
+#include "heap-stats.h"
+#include "adaptive-benchmark.h"
 using namespace std;
 
-enum UnionMode { LAZY, EAGER };
+// Shared with Graph-Benchmark.cpp, which defines NO_DEMO_MAIN
+namespace fib {
+
+// INCREMENTAL consolidates a few link steps per operation instead of all
+// at once, bounding the worst case of any single extractMin. ADAPTIVE
+// stays lazy until the roots outnumber a multiple of log2(n).
+enum UnionMode { LAZY, EAGER, INCREMENTAL, ADAPTIVE };
 enum CostAnalysis { NONE, POTENTIAL, ACCOUNTING };
 
+// Totals from a FibonacciHeap's or PairingHeap's stats(), with the
+// amortized cost under the analysis the heap was built with
+void printSummary(const string& heapName, const HeapStats& st, CostAnalysis analysis) {
+    cout << "\nSummary for " << heapName << endl;
+    cout << "Total Inserts: " << st.insertCount << endl;
+    cout << "Total Extract-Mins: " << st.extractMinCount << endl;
+    cout << "Total Decrease-Keys: " << st.decreaseKeyCount << endl;
+    cout << "Actual Total Cost: " << st.actualCost << endl;
+
+    if (analysis == POTENTIAL) {
+        cout << "Final Potential: " << st.potential << endl;
+        cout << "Amortized Cost (Potential Method): " << st.actualCost + st.potential << endl;
+    } else if (analysis == ACCOUNTING) {
+        cout << "Final Credits: " << st.totalCredits << endl;
+        cout << "Amortized Cost (Accounting Method): " << st.actualCost + st.totalCredits << endl;
+    }
+
+    cout << "-----------------------------------------" << endl;
+}
+
+template <typename Key, typename Value>
 struct FibonacciNode {
-    int key;
+    Key key;
     int degree;
     bool mark;
     FibonacciNode* parent;
     FibonacciNode* child;
     FibonacciNode* left;
     FibonacciNode* right;
+    Value value;
 
-    FibonacciNode(int _key) {
-        key = _key;
+    FibonacciNode(const Key& _key, const Value& _value) : key(_key), value(_value) {
         degree = 0;
         mark = false;
         parent = child = nullptr;
@@ -24,262 +65,955 @@ struct FibonacciNode {
     }
 };
 
+// What insert() hands back: nodes never move once allocated, so the
+// handle stays valid until its entry is extracted or erased
+template <typename Key, typename Value>
+struct FibonacciHandle {
+    FibonacciNode<Key, Value>* ref;
+
+    const Key& key() const { return ref->key; }
+    const Value& value() const { return ref->value; }
+};
+
+// Storage engines for FibonacciHeap. Each owns the nodes, names them by
+// Ref, where Ref() means no node, and resolves a Ref with at(); the heap
+// never reaches a node any other way.
+
+// One pooled node per element, linked by pointers. Nodes never move, so
+// handles survive meld.
+template <typename Key, typename Value>
+class PointerStorage {
+public:
+    typedef FibonacciNode<Key, Value> Node;
+    typedef Node* Ref;
+    typedef FibonacciHandle<Key, Value> Handle;
+
+    // The heap must destroy live nodes itself before the pool goes
+    static constexpr bool releaseRunsDestructor = true;
+
+    Node& at(Ref r) const { return *r; }
+    Handle handle(Ref r) const { return Handle{r}; }
+
+    Ref allocate(const Key& key, const Value& value) { return pool.allocate(key, value); }
+    void release(Ref r) { pool.release(r); }
+
+    // Takes over every node of other; r, one of other's refs, is unchanged
+    Ref adopt(PointerStorage& other, Ref r) {
+        pool.adopt(other.pool);
+        return r;
+    }
+
+    void reserve(size_t) {}
+    size_t bytes() const { return pool.bytes(); }
+
+private:
+    SlabPool<Node> pool;
+};
+
+// 32 bytes or less for keys up to 8 bytes: links are 32-bit indices
+// into one array, offset by one so that 0 can mean none, and degree and
+// mark share a word
+template <typename Key, typename Value>
+struct CompactFibonacciNode {
+    Key key;
+    uint32_t parent;
+    uint32_t child;
+    uint32_t left;
+    uint32_t right;
+    uint32_t degree : 31;
+    uint32_t mark : 1;
+    Value value;
+
+    CompactFibonacciNode(const Key& _key, const Value& _value)
+        : key(_key), parent(0), child(0), left(0), right(0), degree(0), mark(0), value(_value) {}
+};
+
+// Indices stay put when the array grows, so the handle carries the
+// array it indexes as well
+template <typename Key, typename Value>
+struct CompactFibonacciHandle {
+    const vector<CompactFibonacciNode<Key, Value>>* nodes;
+    uint32_t ref;
+
+    const Key& key() const { return (*nodes)[ref - 1].key; }
+    const Value& value() const { return (*nodes)[ref - 1].value; }
+};
+
+// All nodes in one contiguous array, roughly half the footprint of
+// PointerStorage and far fewer cache misses when consolidate and
+// cascadingCut chase links. Freed slots are threaded through left.
+// Meld copies the other heap's array in, so its handles do not survive.
+// Holds at most 2^32 - 1 nodes.
+template <typename Key, typename Value>
+class CompactStorage {
+public:
+    typedef CompactFibonacciNode<Key, Value> Node;
+    typedef uint32_t Ref;
+    typedef CompactFibonacciHandle<Key, Value> Handle;
+
+    // Slots are plain array elements the vector destroys on its own
+    static constexpr bool releaseRunsDestructor = false;
+
+    Node& at(Ref r) { return nodes[r - 1]; }
+    const Node& at(Ref r) const { return nodes[r - 1]; }
+    Handle handle(Ref r) const { return Handle{&nodes, r}; }
+
+    Ref allocate(const Key& key, const Value& value) {
+        Ref r = freeList;
+        if (r) {
+            freeList = at(r).left;
+            at(r) = Node(key, value);
+        } else {
+            nodes.emplace_back(key, value);
+            r = nodes.size();
+        }
+        at(r).left = at(r).right = r;
+        return r;
+    }
+
+    void release(Ref r) {
+        at(r).left = freeList;
+        freeList = r;
+    }
+
+    // Appends other's array, free slots and all, shifting every link by
+    // the same offset; returns where other's ref r now lives
+    Ref adopt(CompactStorage& other, Ref r) {
+        Ref offset = nodes.size();
+        nodes.insert(nodes.end(), make_move_iterator(other.nodes.begin()), make_move_iterator(other.nodes.end()));
+        for (size_t i = offset; i < nodes.size(); i++) {
+            Node& node = nodes[i];
+            if (node.parent) node.parent += offset;
+            if (node.child) node.child += offset;
+            if (node.left) node.left += offset;
+            if (node.right) node.right += offset;
+        }
+
+        // other's free slots, now shifted, go in front of ours
+        if (other.freeList) {
+            Ref last = other.freeList + offset;
+            while (at(last).left) last = at(last).left;
+            at(last).left = freeList;
+            freeList = other.freeList + offset;
+        }
+
+        other.nodes.clear();
+        other.freeList = 0;
+        return r ? r + offset : 0;
+    }
+
+    void reserve(size_t n) { nodes.reserve(n); }
+    size_t bytes() const { return nodes.capacity() * sizeof(Node); }
+
+private:
+    vector<Node> nodes;
+    Ref freeList = 0;
+};
+
+template <typename Key, typename Value = NoValue, typename Compare = less<Key>,
+          template <typename, typename> class Storage = PointerStorage>
 class FibonacciHeap {
+public:
+    typedef Storage<Key, Value> Store;
+    typedef typename Store::Node Node;
+    typedef typename Store::Ref Ref;
+    typedef typename Store::Handle Handle;
+
 private:
-    FibonacciNode* minNode;
+    Ref minNode;
     int totalNodes;
+    int rootCount;          // Wherever INCREMENTAL keeps them
     UnionMode mode;
     CostAnalysis analysis;
 
-    // Cost analysis tracking
-    int actualCost = 0;
-    int totalCredits = 0;   // Accounting
-    int potential = 0;      // Potential
+    HeapStats st;           // Cost analysis tracking
+    Compare less;
+    Store store;            // Owns every node in the heap
 
-    int insertCount = 0;
-    int extractMinCount = 0;
-    int decreaseKeyCount = 0;
+    // consolidate()'s degree table, kept between calls so that
+    // extractMin does not allocate once the heap has reached its size.
+    // tableKeys mirrors the keys of the roots it holds, letting
+    // consolidate() pick the new minimum without chasing the roots.
+    vector<Ref> degreeTable;
+    alignas(64) Key tableKeys[64];
+
+    // INCREMENTAL only. The table above then persists between operations
+    // and holds the consolidated roots, at most one per degree; the root
+    // list holds the rest, always including minNode. carry is the tree
+    // being linked up through the table when the budget ran out.
+    Ref carry;
+    int linkBudget;
+
+    int rootFactor;         // ADAPTIVE only
 
 public:
-    FibonacciHeap(UnionMode m = LAZY, CostAnalysis a = NONE) {
-        minNode = nullptr;
+    // linkBudget caps INCREMENTAL's link steps per operation. It should
+    // stay above twice the degree bound (about 3 log2 n) so that the
+    // children each extractMin releases are folded in before the next.
+    // ADAPTIVE consolidates on insert and meld once the roots number more
+    // than rootFactor * log2(n).
+    FibonacciHeap(UnionMode m = LAZY, CostAnalysis a = NONE, int linkBudget = 64, int rootFactor = 4) {
+        minNode = Ref();
         totalNodes = 0;
+        rootCount = 0;
         mode = m;
         analysis = a;
+        carry = Ref();
+        this->linkBudget = linkBudget;
+        this->rootFactor = rootFactor;
     }
 
-    void insert(int key) {
-        insertCount++;
-        FibonacciNode* node = new FibonacciNode(key);
+    FibonacciHeap(const FibonacciHeap&) = delete;
+    FibonacciHeap& operator=(const FibonacciHeap&) = delete;
+
+    // The store frees the storage; live nodes only need visiting when
+    // Key or Value has a destructor the store will not run
+    ~FibonacciHeap() {
+        if constexpr (Store::releaseRunsDestructor && !is_trivially_destructible<Node>::value) {
+            destroyAll();
+        }
+    }
+
+    Handle insert(const Key& key, const Value& value = Value()) {
+        st.insertCount++;
+        Ref node = store.allocate(key, value);
         if (!minNode) {
             minNode = node;
         } else {
             insertIntoRootList(node);
-            if (node->key < minNode->key) {
+            if (less(at(node).key, at(minNode).key)) {
                 minNode = node;
             }
         }
 
-        if (analysis == ACCOUNTING) totalCredits++;
-        if (analysis == POTENTIAL) potential++;
+        if (analysis == ACCOUNTING) st.totalCredits++;
+        if (analysis == POTENTIAL) st.potential++;
 
         totalNodes++;
-        actualCost++;
+        rootCount++;
+        st.actualCost++;
+        if (mode == INCREMENTAL) {
+            consolidateStep();
+        } else if (mode == ADAPTIVE && rootListTooLong()) {
+            consolidate();
+        }
+        return store.handle(node);
     }
 
-    void unionHeap(FibonacciHeap* other) {
-        if (!other->minNode) return;
+    // Moves every entry of other into this heap, leaving other empty.
+    // With PointerStorage handles into other now refer to this heap; with
+    // CompactStorage they are invalid.
+    void meld(FibonacciHeap& other) {
+        if (&other == this || !other.minNode) return;
+
+        other.flattenRoots();
+        Ref otherMin = store.adopt(other.store, other.minNode);
+        st.totalCredits += other.st.totalCredits;
+        st.potential += other.st.potential;
+        int otherNodes = other.totalNodes;
+        rootCount += other.rootCount;
+        other.minNode = Ref();
+        other.totalNodes = other.rootCount = 0;
+        other.st.totalCredits = other.st.potential = 0;
 
         if (!minNode) {
-            minNode = other->minNode;
-            totalNodes = other->totalNodes;
+            minNode = otherMin;
+            totalNodes = otherNodes;
             return;
         }
 
-        mergeRootLists(other->minNode);
-        if (other->minNode->key < minNode->key) {
-            minNode = other->minNode;
+        mergeRootLists(otherMin);
+        if (less(at(otherMin).key, at(minNode).key)) {
+            minNode = otherMin;
         }
 
-        if (mode == EAGER) {
+        // Count first: consolidate() sizes its table from totalNodes
+        totalNodes += otherNodes;
+
+        if (mode == EAGER || (mode == ADAPTIVE && rootListTooLong())) {
             consolidate();
+        } else if (mode == INCREMENTAL) {
+            consolidateStep();
         }
-
-        totalNodes += other->totalNodes;
     }
 
-    void decreaseKey(FibonacciNode* x, int newKey) {
-        decreaseKeyCount++;
-        if (newKey > x->key) {
-            cout << "New key is greater than current key!" << endl;
-            return;
-        }
-        x->key = newKey;
-        FibonacciNode* y = x->parent;
+    // Returns false, leaving h alone, if newKey is larger than its key
+    bool decreaseKey(Handle h, const Key& newKey) {
+        Ref x = h.ref;
+        if (less(at(x).key, newKey)) return false;
+        st.decreaseKeyCount++;
+        at(x).key = newKey;
+        Ref y = at(x).parent;
 
-        if (y && x->key < y->key) {
+        if (y && less(at(x).key, at(y).key)) {
             cut(x, y);
             cascadingCut(y);
         }
 
-        if (x->key < minNode->key) {
+        if (less(at(x).key, at(minNode).key)) {
+            if (mode == INCREMENTAL) moveToRootList(x);
             minNode = x;
         }
 
-        actualCost++;
+        st.actualCost++;
+        return true;
     }
 
-    FibonacciNode* extractMin() {
-        extractMinCount++;
-        FibonacciNode* z = minNode;
+    // Applies n decrease-keys at once. Every key changes first, so an entry
+    // whose parent dropped below it too stays where it is; then one pass
+    // makes the cuts, and minNode is updated once at the end. Updates that
+    // would raise a key are skipped. Returns how many were applied.
+    size_t decreaseKeyBatch(const pair<Handle, Key>* updates, size_t n) {
+        size_t applied = 0;
+        for (size_t i = 0; i < n; i++) {
+            Ref x = updates[i].first.ref;
+            if (less(at(x).key, updates[i].second)) continue;
+            at(x).key = updates[i].second;
+            st.decreaseKeyCount++;
+            st.actualCost++;
+            applied++;
+        }
+
+        // Entries left alone still satisfy heap order, so rechecking them
+        // costs a comparison and cuts nothing. Only roots can become the
+        // minimum: a child tied with its lowered parent is not cut.
+        Ref best = minNode;
+        for (size_t i = 0; i < n; i++) {
+            Ref x = updates[i].first.ref;
+            Ref y = at(x).parent;
+            if (y && less(at(x).key, at(y).key)) {
+                cut(x, y);
+                cascadingCut(y);
+            }
+            if (!at(x).parent && less(at(x).key, at(best).key)) best = x;
+        }
+
+        if (best != minNode) {
+            if (mode == INCREMENTAL) moveToRootList(best);
+            minNode = best;
+        }
+        return applied;
+    }
+
+    // Removes the entry behind h: treated as a decrease to minus infinity,
+    // so it is cut to the root list, made the minimum and extracted.
+    // h is invalid afterwards.
+    void erase(Handle h) {
+        st.eraseCount++;
+        Ref x = h.ref;
+        Ref y = at(x).parent;
+        if (y) {
+            cut(x, y);
+            cascadingCut(y);
+        } else if (mode == INCREMENTAL) {
+            moveToRootList(x);
+        }
+        minNode = x;
+        store.release(removeMin());
+    }
+
+    // Pops the smallest entry, moving its key/value out when asked, and
+    // recycles its node; false if the heap is empty
+    bool extractMin(Key* key = nullptr, Value* value = nullptr) {
+        st.extractMinCount++;
+        Ref z = removeMin();
+        if (!z) return false;
+
+        if (key) *key = std::move(at(z).key);
+        if (value) *value = std::move(at(z).value);
+        store.release(z);
+        return true;
+    }
+
+    // The heap must not be empty
+    const Key& findMin() const {
+        return at(minNode).key;
+    }
+
+    bool empty() const {
+        return !minNode;
+    }
+
+    size_t size() const {
+        return totalNodes;
+    }
+
+    // Reserves room for n nodes where the store can use it up front
+    void reserve(size_t n) {
+        store.reserve(n);
+    }
+
+    // Bytes held for nodes and the degree table
+    size_t memoryUsage() const {
+        return store.bytes() + degreeTable.capacity() * sizeof(Ref);
+    }
+
+    const HeapStats& stats() const {
+        return st;
+    }
+
+private:
+    // Unlinks minNode, promotes its children and consolidates; the caller
+    // releases the node it returns
+    Ref removeMin() {
+        Ref z = minNode;
         if (z) {
-            if (z->child) {
-                FibonacciNode* child = z->child;
+            rootCount += at(z).degree - 1;
+            if (at(z).child) {
+                Ref child = at(z).child;
                 do {
-                    FibonacciNode* next = child->right;
+                    Ref next = at(child).right;
                     insertIntoRootList(child);
-                    child->parent = nullptr;
+                    at(child).parent = Ref();
                     child = next;
-                } while (child != z->child);
+                } while (child != at(z).child);
             }
 
             removeFromRootList(z);
 
-            if (z == z->right) {
-                minNode = nullptr;
-            } else {
-                minNode = z->right;
+            minNode = z == at(z).right ? Ref() : at(z).right;
+            if (mode == INCREMENTAL) {
+                promoteMin();
+                consolidateStep();
+            } else if (minNode) {
                 consolidate();
             }
 
-            if (analysis == ACCOUNTING) totalCredits--;
-            if (analysis == POTENTIAL) potential--;
+            if (analysis == ACCOUNTING) st.totalCredits--;
+            if (analysis == POTENTIAL) st.potential--;
 
             totalNodes--;
         }
 
-        actualCost++;
+        st.actualCost++;
         return z;
     }
 
-    void printSummary(string heapName) {
-        cout << "\nSummary for " << heapName << endl;
-        cout << "Total Inserts: " << insertCount << endl;
-        cout << "Total Extract-Mins: " << extractMinCount << endl;
-        cout << "Total Decrease-Keys: " << decreaseKeyCount << endl;
-        cout << "Actual Total Cost: " << actualCost << endl;
-
-        if (analysis == POTENTIAL) {
-            cout << "Final Potential: " << potential << endl;
-            cout << "Amortized Cost (Potential Method): " << actualCost + potential << endl;
-        } else if (analysis == ACCOUNTING) {
-            cout << "Final Credits: " << totalCredits << endl;
-            cout << "Amortized Cost (Accounting Method): " << actualCost + totalCredits << endl;
+    // Runs every live node's destructor. Trees can be deep after cuts, so
+    // this walks sibling rings with an explicit stack.
+    void destroyAll() {
+        flattenRoots();
+        vector<Ref> rings;
+        if (minNode) rings.push_back(minNode);
+        while (!rings.empty()) {
+            Ref first = rings.back();
+            rings.pop_back();
+            Ref curr = first;
+            do {
+                Ref next = at(curr).right;
+                if (at(curr).child) rings.push_back(at(curr).child);
+                store.release(curr);
+                curr = next;
+            } while (curr != first);
         }
-
-        cout << "-----------------------------------------" << endl;
+        minNode = Ref();
+        totalNodes = rootCount = 0;
     }
 
-    FibonacciNode* getMin() {
-        return minNode;
+    Node& at(Ref r) { return store.at(r); }
+    const Node& at(Ref r) const { return store.at(r); }
+
+    void insertIntoRootList(Ref node) {
+        at(node).left = minNode;
+        at(node).right = at(minNode).right;
+        at(at(minNode).right).left = node;
+        at(minNode).right = node;
     }
 
-private:
-    void insertIntoRootList(FibonacciNode* node) {
-        node->left = minNode;
-        node->right = minNode->right;
-        minNode->right->left = node;
-        minNode->right = node;
+    void removeFromRootList(Ref node) {
+        at(at(node).left).right = at(node).right;
+        at(at(node).right).left = at(node).left;
     }
 
-    void removeFromRootList(FibonacciNode* node) {
-        node->left->right = node->right;
-        node->right->left = node->left;
+    void mergeRootLists(Ref otherMin) {
+        Ref thisNext = at(minNode).right;
+        Ref otherPrev = at(otherMin).left;
+
+        at(minNode).right = otherMin;
+        at(otherMin).left = minNode;
+        at(thisNext).left = otherPrev;
+        at(otherPrev).right = thisNext;
     }
 
-    void mergeRootLists(FibonacciNode* otherMin) {
-        FibonacciNode* thisNext = minNode->right;
-        FibonacciNode* otherPrev = otherMin->left;
+    // ADAPTIVE: whether the roots have outgrown rootFactor * log2(n)
+    bool rootListTooLong() const {
+        int log2n = 32 - __builtin_clz(totalNodes);
+        return rootCount > rootFactor * log2n;
+    }
 
-        minNode->right = otherMin;
-        otherMin->left = minNode;
-        thisNext->left = otherPrev;
-        otherPrev->right = thisNext;
+    // A root of degree d holds at least F(d+2) nodes, so no degree can
+    // exceed log_phi(n); this walks the Fibonacci numbers to find it
+    static int degreeBound(int n) {
+        int d = 0;
+        int64_t lo = 1, hi = 2;     // F(d+2), F(d+3)
+        while (hi <= n) {
+            int64_t next = lo + hi;
+            lo = hi;
+            hi = next;
+            d++;
+        }
+        return d;
     }
 
     void consolidate() {
         if (!minNode) return;
 
-        int maxDegree = 45;  // log2(max n), can adjust
-        vector<FibonacciNode*> A(maxDegree, nullptr);
+        // No degree reaches 64 while totalNodes is an int, so a uint64_t
+        // can track which slots are filled
+        size_t slots = degreeBound(totalNodes) + 1;
+        if (degreeTable.size() < slots) degreeTable.resize(slots, Ref());
+        uint64_t filled = 0;
 
-        vector<FibonacciNode*> roots;
-        FibonacciNode* curr = minNode;
-        do {
-            roots.push_back(curr);
-            curr = curr->right;
-        } while (curr != minNode);
+        // Open the circular root list into a chain and link each root into
+        // the table as we walk it; roots in the table belong to no list
+        Ref w = minNode;
+        at(at(w).left).right = Ref();
 
-        for (FibonacciNode* w : roots) {
-            FibonacciNode* x = w;
-            int d = x->degree;
+        while (w) {
+            Ref next = at(w).right;
+            Ref x = w;
+            int d = at(x).degree;
 
-            while (A[d]) {
-                FibonacciNode* y = A[d];
-                if (x->key > y->key) swap(x, y);
+            while (filled >> d & 1) {
+                Ref y = degreeTable[d];
+                if (less(at(y).key, at(x).key)) swap(x, y);
 
                 link(y, x);
-                A[d] = nullptr;
+                degreeTable[d] = Ref();
+                filled &= ~(1ULL << d);
                 d++;
             }
-            A[d] = x;
-        }
-
-        minNode = nullptr;
-        for (FibonacciNode* node : A) {
-            if (node) {
-                if (!minNode) {
-                    node->left = node->right = node;
-                    minNode = node;
-                } else {
-                    insertIntoRootList(node);
-                    if (node->key < minNode->key) {
-                        minNode = node;
-                    }
-                }
+            degreeTable[d] = x;
+            tableKeys[d] = at(x).key;
+            filled |= 1ULL << d;
+            w = next;
+        }
+
+        // Rebuild the root list from the table, clearing it for next time
+        Ref best = degreeTable[minSlot(tableKeys, filled, less)];
+        minNode = Ref();
+        for (uint64_t m = filled; m; m &= m - 1) {
+            int d = __builtin_ctzll(m);
+            Ref node = degreeTable[d];
+            degreeTable[d] = Ref();
+
+            if (!minNode) {
+                at(node).left = at(node).right = node;
+                minNode = node;
+            } else {
+                insertIntoRootList(node);
             }
         }
+        minNode = best;
     }
 
-    void link(FibonacciNode* y, FibonacciNode* x) {
-        removeFromRootList(y);
-        if (!x->child) {
-            x->child = y;
-            y->left = y->right = y;
+    // INCREMENTAL: puts root x back in the root list if the table or carry
+    // holds it. Its degree is checked against the table bounds because the
+    // table is only grown as consolidateStep needs it.
+    void moveToRootList(Ref x) {
+        size_t d = at(x).degree;
+        if (x == carry) {
+            carry = Ref();
+        } else if (d < degreeTable.size() && degreeTable[d] == x) {
+            degreeTable[d] = Ref();
+        } else {
+            return;
+        }
+
+        if (!minNode) {
+            at(x).left = at(x).right = x;
         } else {
-            FibonacciNode* child = x->child;
-            y->left = child;
-            y->right = child->right;
-            child->right->left = y;
-            child->right = y;
+            insertIntoRootList(x);
+        }
+    }
+
+    // INCREMENTAL: returns every table root and the carry to the root list
+    void flattenRoots() {
+        if (mode != INCREMENTAL) return;
+        if (carry) moveToRootList(carry);
+        for (Ref root : degreeTable) {
+            if (root) moveToRootList(root);
         }
-        y->parent = x;
-        x->degree++;
-        y->mark = false;
     }
 
-    void cut(FibonacciNode* x, FibonacciNode* y) {
-        if (x->right == x) {
-            y->child = nullptr;
+    // INCREMENTAL: the old minimum just left, and the new one may be in
+    // the root list, the table or the carry. Scanning them costs no links;
+    // the winner goes in the root list so minNode stays there.
+    void promoteMin() {
+        Ref best = minNode;
+        if (minNode) {
+            for (Ref curr = at(minNode).right; curr != minNode; curr = at(curr).right) {
+                if (less(at(curr).key, at(best).key)) best = curr;
+            }
+        }
+        for (Ref root : degreeTable) {
+            if (root && (!best || less(at(root).key, at(best).key))) best = root;
+        }
+        if (carry && (!best || less(at(carry).key, at(best).key))) best = carry;
+
+        if (best) {
+            moveToRootList(best);
+            minNode = best;
+        }
+    }
+
+    // INCREMENTAL: spends up to linkBudget steps folding roots other than
+    // minNode into the table. Placing a root and linking two both count.
+    void consolidateStep() {
+        if (!minNode) return;
+
+        size_t slots = degreeBound(totalNodes) + 1;
+        if (degreeTable.size() < slots) degreeTable.resize(slots, Ref());
+
+        for (int steps = 0; steps < linkBudget; steps++) {
+            if (!carry) {
+                Ref w = at(minNode).right;
+                if (w == minNode) break;
+                removeFromRootList(w);
+                carry = w;
+            }
+
+            int d = at(carry).degree;
+            Ref y = degreeTable[d];
+            if (!y) {
+                degreeTable[d] = carry;
+                carry = Ref();
+                continue;
+            }
+
+            degreeTable[d] = Ref();
+            Ref x = carry;
+            if (less(at(y).key, at(x).key)) swap(x, y);
+            link(y, x);
+            carry = x;
+        }
+    }
+
+    // Makes y a child of x; y must already be out of the root list
+    void link(Ref y, Ref x) {
+        if (!at(x).child) {
+            at(x).child = y;
+            at(y).left = at(y).right = y;
         } else {
-            if (y->child == x) y->child = x->right;
-            x->left->right = x->right;
-            x->right->left = x->left;
+            Ref child = at(x).child;
+            at(y).left = child;
+            at(y).right = at(child).right;
+            at(at(child).right).left = y;
+            at(child).right = y;
         }
-        y->degree--;
+        at(y).parent = x;
+        at(x).degree++;
+        at(y).mark = false;
+        rootCount--;
+    }
+
+    void cut(Ref x, Ref y) {
+        // A consolidated root is filed by degree, which is about to change
+        if (mode == INCREMENTAL && !at(y).parent) moveToRootList(y);
+
+        if (at(x).right == x) {
+            at(y).child = Ref();
+        } else {
+            if (at(y).child == x) at(y).child = at(x).right;
+            at(at(x).left).right = at(x).right;
+            at(at(x).right).left = at(x).left;
+        }
+        at(y).degree--;
 
         insertIntoRootList(x);
-        x->parent = nullptr;
-        x->mark = false;
+        at(x).parent = Ref();
+        at(x).mark = false;
+        rootCount++;
+
+        if (analysis == ACCOUNTING) st.totalCredits++;
+        if (analysis == POTENTIAL) st.potential++;
+        st.actualCost++;
+    }
+
+    // Walks up from y, cutting marked ancestors until it marks one; a loop
+    // rather than recursion, since chains of marked nodes can be long
+    void cascadingCut(Ref y) {
+        for (Ref z = at(y).parent; z; y = z, z = at(y).parent) {
+            if (!at(y).mark) {
+                at(y).mark = true;
+                if (analysis == ACCOUNTING) st.totalCredits++;
+                if (analysis == POTENTIAL) st.potential += 2;
+                st.actualCost++;
+                return;
+            }
+            cut(y, z);
+        }
+    }
+};
+
+// How PairingHeap combines the children of a removed root
+enum PairingMode { TWO_PASS, MULTIPASS };
+
+template <typename Key, typename Value>
+struct PairingNode {
+    Key key;
+    PairingNode* child;     // Leftmost child
+    PairingNode* next;      // Right sibling
+    PairingNode* prev;      // Left sibling, or the parent for a leftmost child
+    Value value;
+
+    PairingNode(const Key& _key, const Value& _value) : key(_key), value(_value) {
+        child = next = prev = nullptr;
+    }
+};
+
+template <typename Key, typename Value>
+struct PairingHandle {
+    PairingNode<Key, Value>* ref;
+
+    const Key& key() const { return ref->key; }
+    const Value& value() const { return ref->value; }
+};
+
+// Single-tree alternative to FibonacciHeap with the same interface and
+// cost tracking. Nodes carry three links and no degree or mark, and
+// every operation is a handful of links, which often wins on
+// decrease-key-heavy work. Costs are counted in the same units as
+// FibonacciHeap: one per operation, one per cut, plus one per link
+// made while combining children.
+template <typename Key, typename Value = NoValue, typename Compare = less<Key>>
+class PairingHeap {
+public:
+    typedef PairingNode<Key, Value> Node;
+    typedef PairingHandle<Key, Value> Handle;
+
+private:
+    Node* root;
+    int totalNodes;
+    PairingMode pairing;
+    CostAnalysis analysis;
+
+    HeapStats st;           // Cost analysis tracking
+    Compare less;
+    SlabPool<Node> pool;    // Owns every node in the heap
+
+    // combine()'s scratch list, kept between calls so that extractMin
+    // does not allocate once the heap has reached its size
+    vector<Node*> subtrees;
+
+public:
+    PairingHeap(PairingMode p = TWO_PASS, CostAnalysis a = NONE) {
+        root = nullptr;
+        totalNodes = 0;
+        pairing = p;
+        analysis = a;
+    }
+
+    PairingHeap(const PairingHeap&) = delete;
+    PairingHeap& operator=(const PairingHeap&) = delete;
+
+    ~PairingHeap() {
+        if constexpr (!is_trivially_destructible<Node>::value) {
+            destroyAll();
+        }
+    }
+
+    Handle insert(const Key& key, const Value& value = Value()) {
+        st.insertCount++;
+        Node* node = pool.allocate(key, value);
+        root = root ? link(root, node) : node;
+
+        if (analysis == ACCOUNTING) st.totalCredits++;
+        if (analysis == POTENTIAL) st.potential++;
+
+        totalNodes++;
+        st.actualCost++;
+        return Handle{node};
+    }
+
+    // Moves every entry of other into this heap, leaving other empty;
+    // handles into other now refer to this heap
+    void meld(PairingHeap& other) {
+        if (&other == this || !other.root) return;
+
+        pool.adopt(other.pool);
+        root = root ? link(root, other.root) : other.root;
+        totalNodes += other.totalNodes;
+        st.totalCredits += other.st.totalCredits;
+        st.potential += other.st.potential;
+
+        other.root = nullptr;
+        other.totalNodes = 0;
+        other.st.totalCredits = other.st.potential = 0;
+        st.actualCost++;
+    }
+
+    // Returns false, leaving h alone, if newKey is larger than its key
+    bool decreaseKey(Handle h, const Key& newKey) {
+        Node* x = h.ref;
+        if (less(x->key, newKey)) return false;
+        st.decreaseKeyCount++;
+        x->key = newKey;
+
+        if (x != root) {
+            detach(x);
+            root = link(root, x);
+            if (analysis == ACCOUNTING) st.totalCredits++;
+            if (analysis == POTENTIAL) st.potential++;
+            st.actualCost++;
+        }
+
+        st.actualCost++;
+        return true;
+    }
+
+    // Removes the entry behind h; h is invalid afterwards
+    void erase(Handle h) {
+        st.eraseCount++;
+        Node* x = h.ref;
+        if (x == root) {
+            pool.release(removeRoot());
+            return;
+        }
+
+        detach(x);
+        Node* rest = combine(x->child);
+        if (rest) root = link(root, rest);
+
+        if (analysis == ACCOUNTING) st.totalCredits--;
+        if (analysis == POTENTIAL) st.potential--;
+        totalNodes--;
+        st.actualCost++;
+        pool.release(x);
+    }
+
+    // Pops the smallest entry, moving its key/value out when asked, and
+    // recycles its node; false if the heap is empty
+    bool extractMin(Key* key = nullptr, Value* value = nullptr) {
+        st.extractMinCount++;
+        Node* z = removeRoot();
+        if (!z) return false;
+
+        if (key) *key = std::move(z->key);
+        if (value) *value = std::move(z->value);
+        pool.release(z);
+        return true;
+    }
+
+    // The heap must not be empty
+    const Key& findMin() const {
+        return root->key;
+    }
+
+    bool empty() const {
+        return !root;
+    }
+
+    size_t size() const {
+        return totalNodes;
+    }
 
-        if (analysis == ACCOUNTING) totalCredits++;
-        if (analysis == POTENTIAL) potential++;
-        actualCost++;
+    const HeapStats& stats() const {
+        return st;
     }
 
-    void cascadingCut(FibonacciNode* y) {
-        FibonacciNode* z = y->parent;
+private:
+    // Unlinks the root and combines its children into the new one; the
+    // caller releases the node it returns
+    Node* removeRoot() {
+        Node* z = root;
         if (z) {
-            if (!y->mark) {
-                y->mark = true;
-                if (analysis == ACCOUNTING) totalCredits++;
-                if (analysis == POTENTIAL) potential += 2;
-                actualCost++;
-            } else {
-                cut(y, z);
-                cascadingCut(z);
+            root = combine(z->child);
+
+            if (analysis == ACCOUNTING) st.totalCredits--;
+            if (analysis == POTENTIAL) st.potential--;
+
+            totalNodes--;
+        }
+
+        st.actualCost++;
+        return z;
+    }
+
+    // Makes the root with the larger key the leftmost child of the other,
+    // returning the one left on top
+    Node* link(Node* a, Node* b) {
+        if (less(b->key, a->key)) swap(a, b);
+        b->prev = a;
+        b->next = a->child;
+        if (a->child) a->child->prev = b;
+        a->child = b;
+        a->next = a->prev = nullptr;
+        return a;
+    }
+
+    // Takes x and its subtree out of its parent's child list
+    void detach(Node* x) {
+        if (x->prev->child == x) {
+            x->prev->child = x->next;
+        } else {
+            x->prev->next = x->next;
+        }
+        if (x->next) x->next->prev = x->prev;
+        x->next = x->prev = nullptr;
+    }
+
+    // Links a sibling list starting at first into one tree. TWO_PASS pairs
+    // neighbours left to right, then folds the pairs right to left;
+    // MULTIPASS keeps linking the two front trees and queueing the result.
+    Node* combine(Node* first) {
+        if (!first) return nullptr;
+        subtrees.clear();
+
+        if (pairing == TWO_PASS) {
+            while (first) {
+                Node* a = first;
+                Node* b = a->next;
+                if (!b) {
+                    subtrees.push_back(a);
+                    break;
+                }
+                first = b->next;
+                subtrees.push_back(link(a, b));
+                st.actualCost++;
+            }
+
+            Node* result = subtrees.back();
+            for (size_t i = subtrees.size() - 1; i-- > 0;) {
+                result = link(subtrees[i], result);
+                st.actualCost++;
             }
+            result->prev = nullptr;
+            return result;
         }
+
+        for (Node* curr = first; curr; curr = curr->next) {
+            subtrees.push_back(curr);
+        }
+        size_t head = 0;
+        while (subtrees.size() - head > 1) {
+            Node* a = subtrees[head++];
+            Node* b = subtrees[head++];
+            subtrees.push_back(link(a, b));
+            st.actualCost++;
+        }
+        Node* result = subtrees[head];
+        result->next = result->prev = nullptr;
+        return result;
+    }
+
+    // Runs every live node's destructor. Trees can be deep, so this walks
+    // sibling lists with an explicit stack.
+    void destroyAll() {
+        vector<Node*> lists;
+        if (root) lists.push_back(root);
+        while (!lists.empty()) {
+            Node* curr = lists.back();
+            lists.pop_back();
+            while (curr) {
+                Node* next = curr->next;
+                if (curr->child) lists.push_back(curr->child);
+                pool.release(curr);
+                curr = next;
+            }
+        }
+        root = nullptr;
+        totalNodes = 0;
     }
 };
 
@@ -288,7 +1022,7 @@ void accounting()
 {
     
     cout << "Testing Lazy Union + Accouting Analysis" << endl;
-    FibonacciHeap lazyHeap(LAZY, ACCOUNTING);
+    FibonacciHeap<int> lazyHeap(LAZY, ACCOUNTING);
 
     lazyHeap.insert(10);
     lazyHeap.insert(20);
@@ -297,10 +1031,10 @@ void accounting()
     lazyHeap.extractMin();
     lazyHeap.insert(3);
 
-    lazyHeap.printSummary("Lazy Heap (Accouting)");
+    printSummary("Lazy Heap (Accouting)", lazyHeap.stats(), ACCOUNTING);
 
     cout << "\nTesting Eager Union + Accouting Analysis" << endl;
-    FibonacciHeap eagerHeap(EAGER, ACCOUNTING);
+    FibonacciHeap<int> eagerHeap(EAGER, ACCOUNTING);
 
     eagerHeap.insert(10);
     eagerHeap.insert(20);
@@ -309,7 +1043,7 @@ void accounting()
     eagerHeap.extractMin();
     eagerHeap.insert(3);
 
-    eagerHeap.printSummary("Eager Heap (Potential)");
+    printSummary("Eager Heap (Potential)", eagerHeap.stats(), ACCOUNTING);
 
 }
 
@@ -317,7 +1051,7 @@ void accounting()
 void potential()
 {
      cout << "Testing Lazy Union + Potential Analysis" << endl;
-    FibonacciHeap lazyHeap(LAZY, POTENTIAL);
+    FibonacciHeap<int> lazyHeap(LAZY, POTENTIAL);
 
     lazyHeap.insert(10);
     lazyHeap.insert(20);
@@ -326,10 +1060,10 @@ void potential()
     lazyHeap.extractMin();
     lazyHeap.insert(3);
 
-    lazyHeap.printSummary("Lazy Heap (Potential)");
+    printSummary("Lazy Heap (Potential)", lazyHeap.stats(), POTENTIAL);
 
     cout << "\nTesting Eager Union + Potential Analysis" << endl;
-    FibonacciHeap eagerHeap(EAGER, POTENTIAL);
+    FibonacciHeap<int> eagerHeap(EAGER, POTENTIAL);
 
     eagerHeap.insert(10);
     eagerHeap.insert(20);
@@ -338,13 +1072,176 @@ void potential()
     eagerHeap.extractMin();
     eagerHeap.insert(3);
 
-    eagerHeap.printSummary("Eager Heap (Potential)");
+    printSummary("Eager Heap (Potential)", eagerHeap.stats(), POTENTIAL);
+}
+
+// A batch that lowers a child and then its parent to the same key. The
+// child stays put, and every entry must still come back out.
+void batchTies()
+{
+    cout << "\nTesting decreaseKeyBatch with a tied child and parent" << endl;
+    for (UnionMode mode : {LAZY, EAGER}) {
+        FibonacciHeap<int> heap(mode);
+        vector<FibonacciHeap<int>::Handle> handles;
+        for (int key = 100; key < 108; key++) handles.push_back(heap.insert(key));
+        heap.extractMin();      // 107 ends up a child of 106
+
+        pair<FibonacciHeap<int>::Handle, int> updates[] = {{handles[7], 5}, {handles[6], 5}};
+        heap.decreaseKeyBatch(updates, 2);
+        int extracted = 0;
+        while (heap.extractMin()) extracted++;
+        cout << (mode == LAZY ? "Lazy" : "Eager") << ": " << extracted << " of 7 entries extracted" << endl;
+    }
+}
+
+// One layout's footprint and time on n inserts, a decrease-key on every
+// fourth entry and n/2 extract-mins
+template <template <typename, typename> class Storage>
+void memoryRun(const string& name, const vector<int>& keys) {
+    typedef FibonacciHeap<int, NoValue, less<int>, Storage> Heap;
+    int n = keys.size();
+
+    size_t reservedBytes;
+    {
+        Heap heap;
+        heap.reserve(n);
+        for (int key : keys) heap.insert(key);
+        reservedBytes = heap.memoryUsage();
+    }
+
+    Heap heap;
+    vector<typename Heap::Handle> handles;
+    handles.reserve(n);
+
+    auto start = chrono::steady_clock::now();
+    for (int key : keys) handles.push_back(heap.insert(key));
+    size_t grownBytes = heap.memoryUsage();
+    for (int i = 0; i < n; i += 4) heap.decreaseKey(handles[i], handles[i].key() - n);
+    for (int i = 0; i < n / 2; i++) heap.extractMin();
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    cout << "  " << name << ": " << sizeof(typename Heap::Node) << " B/node, "
+         << (double)grownBytes / n << " B/element grown, "
+         << (double)reservedBytes / n << " B/element reserved, " << ms << " ms\n";
+}
+
+// Memory per element for the pointer and the compact node layouts
+void benchmarkMemory() {
+    const int n = 3000000;
+    vector<int> keys(n);
+    for (int i = 0; i < n; i++) keys[i] = i;
+    shuffle(keys.begin(), keys.end(), mt19937(n));
+
+    cout << "Memory benchmark: " << n << " int keys\n";
+    memoryRun<PointerStorage>("pointer", keys);
+    memoryRun<CompactStorage>("compact", keys);
+}
+
+// Per-operation latency after a burst of inserts: the burst, then a
+// 50/50 insert/extract stream, every operation timed on its own
+void benchmarkLatency() {
+    const int burst = 1000000;
+    const int stream = 1000000;
+    mt19937 rng(burst);
+    vector<int> keys(burst + stream);
+    for (int& key : keys) key = (int)(rng() >> 2);
+
+    cout << "Latency benchmark: " << burst << " inserts, then " << stream << " mixed operations\n";
+    for (UnionMode mode : {LAZY, EAGER, INCREMENTAL}) {
+        FibonacciHeap<int> heap(mode);
+        vector<double> ns;
+        ns.reserve(burst + stream);
+
+        auto begin = chrono::steady_clock::now();
+        for (int i = 0; i < burst + stream; i++) {
+            auto start = chrono::steady_clock::now();
+            if (i < burst || i % 2) heap.insert(keys[i]);
+            else heap.extractMin();
+            ns.push_back(chrono::duration<double, nano>(chrono::steady_clock::now() - start).count());
+        }
+        double totalMs = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+
+        double firstExtract = ns[burst];
+        sort(ns.begin(), ns.end());
+        cout << "  " << (mode == LAZY ? "lazy" : mode == EAGER ? "eager" : "incremental")
+             << ": total " << totalMs << " ms, first extract " << firstExtract / 1000
+             << " us, p99.99 " << ns[ns.size() * 9999 / 10000] / 1000
+             << " us, max " << ns.back() / 1000 << " us\n";
+    }
+}
+
+// ADAPTIVE against both fixed union modes, see adaptive-benchmark.h
+void benchmarkAdaptive() {
+    runAdaptiveBenchmark([] { return FibonacciHeap<int>(LAZY); }, [] { return FibonacciHeap<int>(EAGER); },
+                         [] { return FibonacciHeap<int>(ADAPTIVE); });
 }
-int main() {
-   
+
+// A Dijkstra-like run on one engine: n entries, then rounds of three
+// decrease-keys on random live entries and one extractMin until empty.
+// Returns milliseconds.
+template <typename Heap>
+double engineRun(Heap& heap, int n) {
+    mt19937 rng(n);
+    vector<typename Heap::Handle> handles;
+    vector<int> live(n), slot(n);
+    handles.reserve(n);
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < n; i++) {
+        handles.push_back(heap.insert((int)(rng() >> 2), i));
+        live[i] = slot[i] = i;
+    }
+    while (!live.empty()) {
+        for (int j = 0; j < 3; j++) {
+            int id = live[rng() % live.size()];
+            heap.decreaseKey(handles[id], handles[id].key() - (int)(rng() % 1024));
+        }
+        int id = 0;
+        heap.extractMin(nullptr, &id);
+        live[slot[id]] = live.back();
+        slot[live.back()] = slot[id];
+        live.pop_back();
+    }
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// FibonacciHeap against both PairingHeap modes on decrease-key-heavy work
+void benchmarkEngines() {
+    const int n = 1000000;
+    cout << "Engine benchmark: " << n << " entries, 3 decrease-keys per extractMin\n";
+    {
+        FibonacciHeap<int, int> heap;
+        cout << "  fibonacci: " << engineRun(heap, n) << " ms\n";
+    }
+    {
+        PairingHeap<int, int> heap(TWO_PASS);
+        cout << "  pairing two-pass: " << engineRun(heap, n) << " ms\n";
+    }
+    {
+        PairingHeap<int, int> heap(MULTIPASS);
+        cout << "  pairing multipass: " << engineRun(heap, n) << " ms\n";
+    }
+}
+
+}  // namespace fib
+
+#ifndef NO_DEMO_MAIN
+using namespace fib;
+
+int main(int argc, char* argv[]) {
+    // "bench" runs every benchmark, "bench <name>" just one of them
+    if (argc > 1 && string(argv[1]) == "bench") {
+        string which = argc > 2 ? argv[2] : "";
+        if (which.empty() || which == "memory") benchmarkMemory();
+        if (which.empty() || which == "latency") benchmarkLatency();
+        if (which.empty() || which == "adaptive") benchmarkAdaptive();
+        if (which.empty() || which == "engines") benchmarkEngines();
+        return 0;
+    }
 
     // accounting();
     potential();
+    batchTies();
 
 
 
@@ -352,6 +1249,7 @@ int main() {
 
     return 0;
 }
+#endif
 
 
 /*
@@ -378,6 +1276,10 @@ Final Potential: 4
 Amortized Cost (Potential Method): 10
 -----------------------------------------
 
+Testing decreaseKeyBatch with a tied child and parent
+Lazy: 7 of 7 entries extracted
+Eager: 7 of 7 entries extracted
+
 
 
 Testing Lazy Union + Accouting Analysis
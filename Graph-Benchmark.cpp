@@ -0,0 +1,346 @@
+// Dijkstra and Prim on generated sparse graphs, once per heap engine.
+// The heaps come straight from their own programs: with NO_DEMO_MAIN
+// defined each one contributes just its namespaced heap code, so every
+// engine runs exactly the code the other files ship.
+//
+//   g++ -std=c++17 -O2 -pthread Graph-Benchmark.cpp -o graph-bench
+//   ./graph-bench [edges] [random|grid|powerlaw]
+//
+// Each run is forked off so its peak RSS is its own. Every engine must
+// agree on the checksum (sum of distances, or the spanning tree weight).
+#include <iostream>
+#include <vector>
+#include <queue>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <functional>
+#include <string>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#define NO_DEMO_MAIN
+#include "Fib-Extention-Eager-vs-Lazy-Analysis.cpp"
+#include "Heaps-Eager-vs-Lazy-Analysis.cpp"
+#include "memory-efficient-task-2.cpp"
+
+using namespace std;
+
+typedef long long Dist;
+
+// Undirected graph in compressed adjacency form: the arcs of vertex v are
+// target/weight[first[v] .. first[v + 1])
+struct Graph {
+    string name;
+    int n = 0;
+    vector<uint32_t> first;
+    vector<int> target;
+    vector<int> weight;
+
+    size_t edges() const { return target.size() / 2; }
+};
+
+Graph buildGraph(const string& name, int n, const vector<pair<int, int>>& edges, mt19937& rng) {
+    Graph g;
+    g.name = name;
+    g.n = n;
+    g.first.assign(n + 1, 0);
+    for (auto& e : edges) {
+        g.first[e.first + 1]++;
+        g.first[e.second + 1]++;
+    }
+    for (int v = 0; v < n; v++) g.first[v + 1] += g.first[v];
+
+    vector<uint32_t> fill(g.first.begin(), g.first.end() - 1);
+    g.target.resize(2 * edges.size());
+    g.weight.resize(2 * edges.size());
+    for (auto& e : edges) {
+        int w = 1 + (int)(rng() % 100);
+        g.target[fill[e.first]] = e.second;
+        g.weight[fill[e.first]++] = w;
+        g.target[fill[e.second]] = e.first;
+        g.weight[fill[e.second]++] = w;
+    }
+    return g;
+}
+
+// Average degree 8. A random path through every vertex keeps it connected.
+Graph randomGraph(size_t m, mt19937& rng) {
+    int n = max<int>(2, (int)(m / 4));
+    vector<int> order(n);
+    for (int v = 0; v < n; v++) order[v] = v;
+    shuffle(order.begin(), order.end(), rng);
+
+    vector<pair<int, int>> edges;
+    edges.reserve(m);
+    for (int i = 1; i < n; i++) edges.push_back({order[i - 1], order[i]});
+    while (edges.size() < m) {
+        int u = rng() % n, v = rng() % n;
+        if (u != v) edges.push_back({u, v});
+    }
+    return buildGraph("random", n, edges, rng);
+}
+
+// Square 4-neighbour grid with about m edges
+Graph gridGraph(size_t m, mt19937& rng) {
+    int side = max(2, (int)sqrt(m / 2.0));
+    vector<pair<int, int>> edges;
+    edges.reserve(2 * (size_t)side * side);
+    for (int r = 0; r < side; r++) {
+        for (int c = 0; c < side; c++) {
+            int v = r * side + c;
+            if (c + 1 < side) edges.push_back({v, v + 1});
+            if (r + 1 < side) edges.push_back({v, v + side});
+        }
+    }
+    return buildGraph("grid", side * side, edges, rng);
+}
+
+// Preferential attachment: each new vertex links to 4 earlier ones picked
+// in proportion to their degree, giving a power-law degree tail
+Graph powerLawGraph(size_t m, mt19937& rng) {
+    const int k = 4;
+    int n = max<int>(k + 1, (int)(m / k));
+    vector<pair<int, int>> edges;
+    vector<int> endpoints;
+    edges.reserve(m);
+    endpoints.reserve(2 * m + 2 * k);
+    for (int v = 1; v <= k; v++) {
+        edges.push_back({0, v});
+        endpoints.push_back(0);
+        endpoints.push_back(v);
+    }
+    for (int v = k + 1; v < n; v++) {
+        for (int j = 0; j < k; j++) {
+            int u = endpoints[rng() % endpoints.size()];
+            edges.push_back({v, u});
+            endpoints.push_back(u);
+        }
+        for (int j = 0; j < k; j++) endpoints.push_back(v);
+    }
+    return buildGraph("powerlaw", n, edges, rng);
+}
+
+// What one run reports back to the parent process
+struct RunResult {
+    double ms = 0;
+    uint64_t ops = 0;           // inserts + decrease-keys + extracts
+    uint64_t actualCost = 0;    // The heap's own counter, 0 if it has none
+    bool hasCost = false;
+    bool skipped = false;
+    Dist checksum = 0;
+};
+
+// Dijkstra (prim == false) or Prim from vertex 0 with one handle per
+// vertex, lowering keys in place
+template <typename Heap>
+RunResult decreaseKeyRun(const Graph& g, Heap& heap, bool prim) {
+    RunResult r;
+    vector<Dist> key(g.n, LLONG_MAX);
+    vector<typename Heap::Handle> handle(g.n);
+    vector<char> state(g.n, 0);     // 0 unseen, 1 queued, 2 done
+
+    auto start = chrono::steady_clock::now();
+    key[0] = 0;
+    handle[0] = heap.insert(0, 0);
+    state[0] = 1;
+    r.ops++;
+
+    Dist d;
+    int u;
+    while (heap.extractMin(&d, &u)) {
+        r.ops++;
+        state[u] = 2;
+        r.checksum += d;
+        for (uint32_t a = g.first[u]; a < g.first[u + 1]; a++) {
+            int v = g.target[a];
+            if (state[v] == 2) continue;
+            Dist nd = prim ? g.weight[a] : d + g.weight[a];
+            if (state[v] == 0) {
+                key[v] = nd;
+                handle[v] = heap.insert(nd, v);
+                state[v] = 1;
+                r.ops++;
+            } else if (nd < key[v]) {
+                key[v] = nd;
+                heap.decreaseKey(handle[v], nd);
+                r.ops++;
+            }
+        }
+    }
+    r.ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    r.actualCost = heap.stats().actualCost;
+    r.hasCost = true;
+    return r;
+}
+
+// The same search for heaps without decrease-key: push a fresh entry on
+// every improvement and drop stale ones as they come out
+template <typename Queue>
+RunResult lazyRun(const Graph& g, Queue& queue, bool prim) {
+    RunResult r;
+    vector<Dist> key(g.n, LLONG_MAX);
+    vector<char> done(g.n, 0);
+
+    auto start = chrono::steady_clock::now();
+    key[0] = 0;
+    queue.push(0, 0);
+    r.ops++;
+
+    Dist d;
+    int u;
+    while (queue.pop(&d, &u)) {
+        r.ops++;
+        if (done[u] || d != key[u]) continue;
+        done[u] = 1;
+        r.checksum += d;
+        for (uint32_t a = g.first[u]; a < g.first[u + 1]; a++) {
+            int v = g.target[a];
+            if (done[v]) continue;
+            Dist nd = prim ? g.weight[a] : d + g.weight[a];
+            if (nd < key[v]) {
+                key[v] = nd;
+                queue.push(nd, v);
+                r.ops++;
+            }
+        }
+    }
+    r.ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    return r;
+}
+
+struct StdQueue {
+    priority_queue<pair<Dist, int>, vector<pair<Dist, int>>, greater<pair<Dist, int>>> pq;
+
+    void push(Dist key, int v) { pq.push({key, v}); }
+    bool pop(Dist* key, int* v) {
+        if (pq.empty()) return false;
+        *key = pq.top().first;
+        *v = pq.top().second;
+        pq.pop();
+        return true;
+    }
+};
+
+// The perfect heaps only hold ints, so key and vertex are packed as
+// key * n + v. Runs whose keys would not fit are reported as skipped.
+template <typename Heap>
+struct PerfectQueue {
+    Heap heap;
+    int n;
+    size_t count = 0;
+    bool overflow = false;
+
+    PerfectQueue(int _n) : n(_n) {}
+
+    void push(Dist key, int v) {
+        if (key > (INT_MAX - 1 - v) / n) {
+            overflow = true;
+            return;
+        }
+        heap.insert((int)(key * n + v));
+        count++;
+    }
+    bool pop(Dist* key, int* v) {
+        if (count == 0 || overflow) return false;
+        int packed = heap.extractMin();
+        count--;
+        *key = packed / n;
+        *v = packed % n;
+        return true;
+    }
+};
+
+template <typename Heap>
+RunResult perfectRun(const Graph& g, bool prim) {
+    PerfectQueue<Heap> queue(g.n);
+    RunResult r = lazyRun(g, queue, prim);
+    r.skipped = queue.overflow;
+    r.actualCost = queue.heap.stats().actualCost;
+    r.hasCost = true;
+    return r;
+}
+
+// Forks, runs the engine in the child and reads its result back through a
+// pipe; the child's peak RSS comes from wait4
+bool runIsolated(const function<RunResult()>& run, RunResult& result, long& peakKb) {
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+    cout.flush();
+    pid_t pid = fork();
+    if (pid < 0) return false;
+    if (pid == 0) {
+        close(fds[0]);
+        RunResult r = run();
+        ssize_t written = write(fds[1], &r, sizeof(r));
+        _exit(written == (ssize_t)sizeof(r) ? 0 : 1);
+    }
+    close(fds[1]);
+    ssize_t got = read(fds[0], &result, sizeof(result));
+    close(fds[0]);
+    int status = 0;
+    rusage usage;
+    wait4(pid, &status, 0, &usage);
+    peakKb = usage.ru_maxrss;
+    return got == (ssize_t)sizeof(result) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+void report(const string& engine, const function<RunResult()>& run) {
+    RunResult r;
+    long peakKb = 0;
+    cout << "    " << engine << ": ";
+    if (!runIsolated(run, r, peakKb)) {
+        cout << "failed\n";
+        return;
+    }
+    if (r.skipped) {
+        cout << "skipped\n";
+        return;
+    }
+    cout << r.ms << " ms, " << (uint64_t)(r.ops / (r.ms / 1000)) << " ops/s, peak RSS "
+         << peakKb / 1024 << " MB, checksum " << r.checksum;
+    if (r.hasCost) cout << ", actualCost " << r.actualCost;
+    cout << "\n";
+}
+
+void benchmarkGraph(const Graph& g) {
+    cout << g.name << ": " << g.n << " vertices, " << g.edges() << " edges\n";
+    for (bool prim : {false, true}) {
+        cout << "  " << (prim ? "prim" : "dijkstra") << "\n";
+        report("fibonacci", [&] {
+            fib::FibonacciHeap<Dist, int> heap(fib::LAZY, fib::POTENTIAL);
+            return decreaseKeyRun(g, heap, prim);
+        });
+        report("pairing", [&] {
+            fib::PairingHeap<Dist, int> heap(fib::TWO_PASS, fib::POTENTIAL);
+            return decreaseKeyRun(g, heap, prim);
+        });
+        report("binomial", [&] {
+            binomial::BinomialHeap<Dist, int, less<Dist>, binomial::EagerUnion, binomial::PotentialCost> heap;
+            return decreaseKeyRun(g, heap, prim);
+        });
+        report("perfect binary", [&] { return perfectRun<pbt::PerfectBinaryHeap<>>(g, prim); });
+        report("perfect 8-ary", [&] { return perfectRun<pbt::DaryPerfectHeap<8>>(g, prim); });
+        report("priority_queue", [&] {
+            StdQueue queue;
+            return lazyRun(g, queue, prim);
+        });
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t m = argc > 1 ? stoull(argv[1]) : 1000000;
+    string which = argc > 2 ? argv[2] : "";
+    m = min<size_t>(max<size_t>(m, 16), 10000000);
+
+    mt19937 rng(12345);
+    if (which.empty() || which == "random") benchmarkGraph(randomGraph(m, rng));
+    if (which.empty() || which == "grid") benchmarkGraph(gridGraph(m, rng));
+    if (which.empty() || which == "powerlaw") benchmarkGraph(powerLawGraph(m, rng));
+    return 0;
+}
@@ -1,302 +1,1058 @@
 #include <iostream>
 #include <vector>
+#include <deque>
 #include <climits>
+#include <new>
+#include <utility>
+#include <functional>
+#include <type_traits>
+#include <cstdint>
+#include <chrono>
+#include <string>
+#include <iterator>
+#include <random>
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include "slab-pool.h"
+#include "min-slot.h"
+#include "heap-stats.h"
+#include "adaptive-benchmark.h"
 using namespace std;
 
-enum UnionMode { LAZY, EAGER };
+// Graph-Benchmark.cpp includes this file with NO_DEMO_MAIN defined; the
+// namespace keeps its names apart from the other heap programs
+namespace binomial {
+
+enum UnionMode { LAZY, EAGER, ADAPTIVE };
 enum CostAnalysis { NONE, ACCOUNTING, POTENTIAL };
 
+// Union policies: when roots get linked
+struct LazyUnion { static constexpr UnionMode mode = LAZY; };
+struct EagerUnion { static constexpr UnionMode mode = EAGER; };
+
+// Defers like LazyUnion until the roots outnumber RootFactor * log2(n),
+// then folds them all in
+template <int RootFactor = 2>
+struct AdaptiveUnion {
+    static constexpr UnionMode mode = ADAPTIVE;
+    static constexpr int rootFactor = RootFactor;
+};
+
+// Cost policies get one callback per unit of work. NoCost's callbacks are
+// empty, so a production heap carries no bookkeeping at all.
+struct NoCost {
+    static constexpr CostAnalysis analysis = NONE;
+
+    void step() {}
+    void newTree() {}
+    void lostTree() {}
+    void countInsert() {}
+    void countExtractMin() {}
+    void countDecreaseKey() {}
+    void countErase() {}
+    void absorb(const NoCost&) {}
+    HeapStats snapshot() const { return HeapStats(); }
+};
+
+struct CostCounters {
+    HeapStats stats;
+
+    void step() { stats.actualCost++; }
+    void countInsert() { stats.insertCount++; }
+    void countExtractMin() { stats.extractMinCount++; }
+    void countDecreaseKey() { stats.decreaseKeyCount++; }
+    void countErase() { stats.eraseCount++; }
+    HeapStats snapshot() const { return stats; }
+};
+
+struct AccountingCost : CostCounters {
+    static constexpr CostAnalysis analysis = ACCOUNTING;
+
+    void newTree() { stats.totalCredits += 1; }    // assign 1 credit
+    void lostTree() { stats.totalCredits -= 1; }   // spent by a link or a removed root
+    void absorb(const AccountingCost& other) { stats.totalCredits += other.stats.totalCredits; }
+};
+
+struct PotentialCost : CostCounters {
+    static constexpr CostAnalysis analysis = POTENTIAL;
+
+    void newTree() { stats.potential += 1; }       // One unit per tree
+    void lostTree() { stats.potential -= 1; }
+    void absorb(const PotentialCost& other) { stats.potential += other.stats.potential; }
+};
+
+template <typename Key, typename Value>
 struct BinomialNode {
-    int key;
+    Key key;
     int degree;
     BinomialNode* parent;
     BinomialNode* child;
     BinomialNode* sibling;
+    BinomialNode** handle;  // Cell the caller's BinomialHandle points at
+    Value value;
+
+    BinomialNode(const Key& _key, const Value& _value)
+        : key(_key), degree(0), parent(nullptr), child(nullptr), sibling(nullptr), handle(nullptr), value(_value) {}
+};
+
+// Stable reference to an inserted key. It stays valid, however the trees
+// are relinked, until that key is extracted or erased.
+template <typename Key, typename Value>
+struct BinomialHandle {
+    BinomialNode<Key, Value>** cell;
 
-    BinomialNode(int _key) : key(_key), degree(0), parent(nullptr), child(nullptr), sibling(nullptr) {}
+    const Key& key() const { return (*cell)->key; }
+    Value& value() const { return (*cell)->value; }
 };
 
+template <typename Key, typename Value, typename Compare>
+class ShardedBinomialHeap;
+
+template <typename Key, typename Value = NoValue, typename Compare = less<Key>,
+          typename UnionPolicy = EagerUnion, typename CostPolicy = NoCost>
 class BinomialHeap {
+    template <typename, typename, typename>
+    friend class ShardedBinomialHeap;
+
+public:
+    typedef BinomialNode<Key, Value> Node;
+    typedef BinomialHandle<Key, Value> Handle;
+
 private:
-    BinomialNode* head;
-    UnionMode mode;
-    CostAnalysis analysis;
+    static const int MAX_DEGREE = 64;  // Degrees stay below log2(n) + 1
+    static constexpr UnionMode mode = UnionPolicy::mode;
+    static constexpr CostAnalysis analysis = CostPolicy::analysis;
 
-    // For cost tracking
-    int totalCredits = 0;       // Accounting
-    int potential = 0;          // Potential
-    int actualCost = 0;         // Raw step count
+    SlabPool<Node> pool;
+    SlabPool<Node*> handleCells;
 
-    int insertCount = 0;
-    int extractMinCount = 0;
+    // Consolidated forest: at most one tree per degree, roots[d] valid
+    // exactly when bit d of rootMask is set. rootKeys[d] mirrors
+    // roots[d]->key so the minimum is found without touching the nodes.
+    uint64_t rootMask;
+    Node* roots[MAX_DEGREE];
+    alignas(64) Key rootKeys[MAX_DEGREE];
 
-public:
-    BinomialHeap(UnionMode m = EAGER, CostAnalysis a = NONE) : head(nullptr), mode(m), analysis(a) {}
+    Node* pending;              // LAZY/ADAPTIVE: unconsolidated roots
+    size_t pendingCount;
+    Node* minRoot;              // Cached smallest root, nullptr when empty
+    size_t count;
 
-    static BinomialNode* mergeRootLists(BinomialNode* h1, BinomialNode* h2, int& mergeCostCounter) {
-        if (!h1) return h2;
-        if (!h2) return h1;
+    Compare less;
+    CostPolicy cost;
 
-        BinomialNode* head = nullptr;
-        BinomialNode* tail = nullptr;
+    // Scratch tournament for extractK. Keys are copied in so comparisons
+    // never chase node pointers.
+    struct Candidate {
+        Key key;
+        Node* node;
+    };
+    vector<Candidate> frontier;
 
-        if (h1->degree <= h2->degree) {
-            head = tail = h1;
-            h1 = h1->sibling;
-        } else {
-            head = tail = h2;
-            h2 = h2->sibling;
-        }
+public:
+    BinomialHeap(const Compare& c = Compare())
+        : rootMask(0), roots(), pending(nullptr), pendingCount(0), minRoot(nullptr), count(0), less(c) {}
 
-        while (h1 && h2) {
-            mergeCostCounter++;  // cost for comparing/merging
-            if (h1->degree <= h2->degree) {
-                tail->sibling = h1;
-                h1 = h1->sibling;
-            } else {
-                tail->sibling = h2;
-                h2 = h2->sibling;
-            }
-            tail = tail->sibling;
-        }
+    BinomialHeap(const BinomialHeap&) = delete;
+    BinomialHeap& operator=(const BinomialHeap&) = delete;
 
-        tail->sibling = (h1) ? h1 : h2;
-        return head;
+    // The pools free the storage; live nodes only need visiting when Key
+    // or Value has a destructor
+    ~BinomialHeap() {
+        if constexpr (!is_trivially_destructible<Node>::value) {
+            destroyAll();
+        }
     }
 
-    static void linkTrees(BinomialNode* y, BinomialNode* z) {
+    static void linkTrees(Node* y, Node* z) {
         y->parent = z;
         y->sibling = z->child;
         z->child = y;
         z->degree += 1;
     }
 
-    void insert(int key) {
-        insertCount++;
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+    HeapStats stats() const { return cost.snapshot(); }
 
-        BinomialHeap* temp = new BinomialHeap(mode, analysis);
-        temp->head = new BinomialNode(key);
+    Handle insert(const Key& key, const Value& value = Value()) {
+        cost.countInsert();
 
-        if (analysis == ACCOUNTING) totalCredits += 1;  // assign 1 credit
-        if (analysis == POTENTIAL) potential += 1;      // +1 tree
+        Node* node = pool.allocate(key, value);
+        node->handle = handleCells.allocate(node);
+        count++;
+        cost.newTree();
 
-        if (mode == LAZY) {
-            lazyUnion(temp);
+        if (!minRoot || less(key, minRoot->key)) {
+            minRoot = node;
+        }
+        if constexpr (mode != EAGER) {
+            node->sibling = pending;
+            pending = node;
+            pendingCount++;
+            if constexpr (mode == ADAPTIVE) foldIfLong();
         } else {
-            eagerUnion(temp);
+            cost.step();
+            addTree(node);
         }
-        printCosts("Insert " + to_string(key));
+        return Handle{node->handle};
+    }
+
+    // Adds the keys in [first, last) in O(n) total: all nodes come from one
+    // contiguous block, and adjacent trees are paired by degree like a
+    // binary counter before the finished forest is melded in.
+    template <typename KeyIt>
+    void build(KeyIt first, KeyIt last) {
+        build(first, last, DefaultValues());
     }
 
-    void lazyUnion(BinomialHeap* other) {
-        int mergeSteps = 0;
-        head = mergeRootLists(head, other->head, mergeSteps);
-        actualCost += mergeSteps;
+    // Same, taking each key's payload from values
+    template <typename KeyIt, typename ValueIt>
+    void build(KeyIt first, KeyIt last, ValueIt values) {
+        int n = (int)distance(first, last);
+        if (n == 0) return;
+
+        Node* nodes = pool.allocateBlock(n);
+        Node** cells = handleCells.allocateBlock(n);
+        Node* forest[MAX_DEGREE];
+        uint64_t forestMask = 0;
+
+        for (int i = 0; i < n; i++, ++first, ++values) {
+            Node* tree = new (nodes + i) Node(*first, *values);
+            cells[i] = tree;
+            tree->handle = cells + i;
+            cost.countInsert();
+            cost.newTree();
+            carryInto(forest, forestMask, tree);
+        }
+        count += n;
+        meldForest(forest, forestMask);
+    }
+
+    // Inserts n keys (with payloads when values is given) as one temporary
+    // forest melded in a single pass. Nodes come from the pool's free list
+    // like insert(), so steady-state batches allocate nothing. A handle
+    // per key is written to handles when given.
+    void insertBatch(const Key* keys, size_t n, const Value* values = nullptr, Handle* handles = nullptr) {
+        Node* forest[MAX_DEGREE];
+        uint64_t forestMask = 0;
+
+        for (size_t i = 0; i < n; i++) {
+            Node* tree = pool.allocate(keys[i], values ? values[i] : Value());
+            tree->handle = handleCells.allocate(tree);
+            if (handles) handles[i] = Handle{tree->handle};
+            cost.countInsert();
+            cost.newTree();
+            carryInto(forest, forestMask, tree);
+        }
+        count += n;
+        meldForest(forest, forestMask);
+    }
+
+    // Pops up to k smallest entries in order into keys (and values when
+    // given) and returns how many were popped. A small tournament over the
+    // candidates -- roots first, then the children of each popped node --
+    // picks each item without rescanning the forest; the subtrees left
+    // hanging are added back once at the end.
+    size_t extractK(size_t k, Key* keys, Value* values = nullptr) {
+        foldPending(nullptr);
+
+        auto later = [this](const Candidate& a, const Candidate& b) { return less(b.key, a.key); };
+        frontier.clear();
+        for (uint64_t m = rootMask; m; m &= m - 1) {
+            cost.step();
+            Node* tree = roots[__builtin_ctzll(m)];
+            frontier.push_back(Candidate{tree->key, tree});
+        }
+        make_heap(frontier.begin(), frontier.end(), later);
+
+        size_t popped = 0;
+        for (; popped < k && !frontier.empty(); popped++) {
+            pop_heap(frontier.begin(), frontier.end(), later);
+            Node* top = frontier.back().node;
+            frontier.pop_back();
+
+            cost.countExtractMin();
+            cost.lostTree();
+            keys[popped] = top->key;
+            if (values) values[popped] = top->value;
+            if (!top->parent) {
+                rootMask &= ~(1ULL << top->degree);
+            }
+            for (Node* child = top->child; child; child = child->sibling) {
+                cost.step();
+                frontier.push_back(Candidate{child->key, child});
+                push_heap(frontier.begin(), frontier.end(), later);
+            }
+
+            handleCells.release(top->handle);
+            pool.release(top);
+        }
+        count -= popped;
+
+        // Unpopped roots never left the forest; the rest of the frontier
+        // hung off popped nodes and become roots now. Detach them all
+        // before adding any, since adding links them under one another.
+        size_t orphans = 0;
+        for (const Candidate& c : frontier) {
+            if (c.node->parent) {
+                c.node->parent = nullptr;
+                frontier[orphans++] = c;
+            }
+        }
+        for (size_t i = 0; i < orphans; i++) {
+            cost.step();
+            addTree(frontier[i].node);
+        }
+        updateMinRoot();
+        return popped;
     }
 
-    void eagerUnion(BinomialHeap* other) {
-        int mergeSteps = 0;
-        head = mergeRootLists(head, other->head, mergeSteps);
-        actualCost += mergeSteps;
-        if (!head) return;
+    // Hands whole trees, biggest first, to other until the two hold about
+    // the same number of keys; O(log n). The moved nodes stay in this
+    // heap's slabs, so this is only for heaps that are destroyed together,
+    // like the shards of a ShardedBinomialHeap.
+    void splitInto(BinomialHeap& other) {
+        foldPending(nullptr);
+        if (count <= other.count) return;
+
+        size_t give = (count - other.count) / 2;
+        for (int d = MAX_DEGREE - 1; d >= 0 && give; d--) {
+            size_t treeSize = size_t(1) << d;
+            if (!(rootMask & (1ULL << d)) || treeSize > give) continue;
+
+            Node* tree = roots[d];
+            rootMask &= ~(1ULL << d);
+            give -= treeSize;
+            count -= treeSize;
+            other.count += treeSize;
+            cost.lostTree();
+            other.cost.newTree();
 
-        BinomialNode* prev = nullptr;
-        BinomialNode* curr = head;
-        BinomialNode* next = curr->sibling;
+            if (!other.minRoot || less(tree->key, other.minRoot->key)) {
+                other.minRoot = tree;
+            }
+            other.addTree(tree);
+        }
+        updateMinRoot();
+    }
 
-        while (next) {
-            actualCost++;  // each comparison
-            if ((curr->degree != next->degree) ||
-                (next->sibling && next->sibling->degree == curr->degree)) {
-                prev = curr;
-                curr = next;
+    // Moves every key of other into this heap, leaving other empty. The
+    // consolidated forests are added like two binary numbers, so only
+    // degrees occupied in both heaps cost a link. Handles into other stay
+    // valid and now refer to this heap.
+    void meld(BinomialHeap& other) {
+        if (&other == this) return;
+        if (other.minRoot && (!minRoot || less(other.minRoot->key, minRoot->key))) {
+            minRoot = other.minRoot;
+        }
+
+        for (uint64_t m = other.rootMask; m; m &= m - 1) {
+            cost.step();
+            addTree(other.roots[__builtin_ctzll(m)]);
+        }
+        Node* curr = other.pending;
+        while (curr) {
+            cost.step();
+            Node* next = curr->sibling;
+            if constexpr (mode != EAGER) {
+                curr->sibling = pending;
+                pending = curr;
+                pendingCount++;
             } else {
-                if (curr->key <= next->key) {
-                    curr->sibling = next->sibling;
-                    linkTrees(next, curr);
-                    if (analysis == ACCOUNTING) totalCredits -= 1;
-                    if (analysis == POTENTIAL) potential -= 1;
-                } else {
-                    if (!prev) {
-                        head = next;
-                    } else {
-                        prev->sibling = next;
-                    }
-                    linkTrees(curr, next);
-                    curr = next;
-                    if (analysis == ACCOUNTING) totalCredits -= 1;
-                    if (analysis == POTENTIAL) potential -= 1;
-                }
+                addTree(curr);
             }
-            next = curr->sibling;
+            curr = next;
+        }
+
+        pool.adopt(other.pool);
+        handleCells.adopt(other.handleCells);
+        count += other.count;
+        cost.absorb(other.cost);
+        if constexpr (mode == ADAPTIVE) foldIfLong();
+
+        other.rootMask = 0;
+        other.pending = other.minRoot = nullptr;
+        other.pendingCount = 0;
+        other.count = 0;
+        other.cost = CostPolicy();
+    }
+
+    // Returns false, leaving the entry alone, if newKey is larger
+    bool decreaseKey(Handle h, const Key& newKey) {
+        Node* node = *h.cell;
+        if (less(node->key, newKey)) return false;
+        cost.countDecreaseKey();
+
+        node->key = newKey;
+        node = bubbleUp(node, false);
+        if (!node->parent && (rootMask >> node->degree & 1) && roots[node->degree] == node) {
+            rootKeys[node->degree] = newKey;
+        }
+        if (less(newKey, minRoot->key)) {
+            minRoot = node;
+        }
+        return true;
+    }
+
+    // Removes the entry behind h wherever it sits; h is invalid afterwards
+    void erase(Handle h) {
+        cost.countErase();
+
+        removeRoot(bubbleUp(*h.cell, true));
+    }
+
+    // Drops every entry; storage stays with the heap for reuse. Slabs are
+    // handed back whole, after a walk over the nodes only when Key or Value
+    // has a destructor.
+    void clear() {
+        if constexpr (!is_trivially_destructible<Node>::value) {
+            destroyAll();
         }
+        pool.reset();
+        handleCells.reset();
+        rootMask = 0;
+        pending = nullptr;
+        pendingCount = 0;
+        minRoot = nullptr;
+        count = 0;
+    }
+
+    // O(1): the smallest root is kept up to date by every operation.
+    // The heap must not be empty.
+    const Key& findMin() const {
+        return minRoot->key;
     }
 
-    int extractMin() {
-        if (!head) return -1;
+    // Pops the smallest entry into key/value when given; false if empty
+    bool extractMin(Key* key = nullptr, Value* value = nullptr) {
+        if (!minRoot) return false;
 
-        extractMinCount++;
+        cost.countExtractMin();
 
-        BinomialNode* minNode = head;
-        BinomialNode* minPrev = nullptr;
-        BinomialNode* curr = head;
-        BinomialNode* prev = nullptr;
+        if (key) *key = minRoot->key;
+        if (value) *value = minRoot->value;
+        removeRoot(minRoot);
+        return true;
+    }
+
+private:
+    struct DefaultValues {
+        Value operator*() const { return Value(); }
+        DefaultValues& operator++() { return *this; }
+    };
+
+    // Links two roots of equal degree, returning the one left on top
+    Node* linkRoots(Node* a, Node* b) {
+        cost.step();
+        cost.lostTree();
+        if (less(b->key, a->key)) swap(a, b);
+        linkTrees(b, a);
+        return a;
+    }
+
+    // Binary counter increment on a forest under construction
+    void carryInto(Node** forest, uint64_t& forestMask, Node* tree) {
+        int d = tree->degree;
+        while (forestMask & (1ULL << d)) {
+            forestMask &= ~(1ULL << d);
+            tree = linkRoots(forest[d], tree);
+            d++;
+        }
+        forest[d] = tree;
+        forestMask |= 1ULL << d;
+    }
 
-        int min = curr->key;
+    // Adds a finished forest to the heap's own
+    void meldForest(Node** forest, uint64_t forestMask) {
+        for (uint64_t m = forestMask; m; m &= m - 1) {
+            Node* tree = forest[__builtin_ctzll(m)];
+            if (!minRoot || less(tree->key, minRoot->key)) {
+                minRoot = tree;
+            }
+            cost.step();
+            addTree(tree);
+        }
+    }
+
+    // LAZY/ADAPTIVE: moves the pending roots, except skip, into the forest
+    void foldPending(Node* skip) {
+        Node* curr = pending;
         while (curr) {
-            actualCost++;
-            if (curr->key < min) {
-                min = curr->key;
-                minNode = curr;
-                minPrev = prev;
+            Node* next = curr->sibling;
+            if (curr != skip) {
+                cost.step();
+                addTree(curr);
             }
-            prev = curr;
-            curr = curr->sibling;
+            curr = next;
         }
+        pending = nullptr;
+        pendingCount = 0;
+    }
 
-        if (minPrev) {
-            minPrev->sibling = minNode->sibling;
-        } else {
-            head = minNode->sibling;
+    // ADAPTIVE: folds the pending roots in once the root list outgrows
+    // rootFactor * log2(n)
+    void foldIfLong() {
+        if (!count) return;
+        size_t rootCount = pendingCount + __builtin_popcountll(rootMask);
+        size_t log2n = 64 - __builtin_clzll(count);
+        if (rootCount > UnionPolicy::rootFactor * log2n) foldPending(nullptr);
+    }
+
+    // Adds a tree to the forest as a binary counter increment: every
+    // occupied slot from the tree's degree upwards is a carry
+    void addTree(Node* tree) {
+        int d = tree->degree;
+        while (rootMask & (1ULL << d)) {
+            Node* other = roots[d];
+            rootMask &= ~(1ULL << d);
+            tree = linkRoots(tree, other);
+            if (other == minRoot) minRoot = tree;
+            d++;
         }
+        roots[d] = tree;
+        rootKeys[d] = tree->key;
+        rootMask |= 1ULL << d;
+    }
+
+    // Moves node's entry and handle up the parent chain until heap order
+    // holds, or all the way to the root when toRoot is set. Returns the node
+    // the entry ended up in.
+    Node* bubbleUp(Node* node, bool toRoot) {
+        Node* parent = node->parent;
+        while (parent && (toRoot || less(node->key, parent->key))) {
+            cost.step();
+            swap(node->key, parent->key);
+            swap(node->value, parent->value);
+            swap(node->handle, parent->handle);
+            *node->handle = node;
+            *parent->handle = parent;
 
-        BinomialNode* child = minNode->child;
-        BinomialNode* reversed = nullptr;
-        while (child) {
-            actualCost++;
-            BinomialNode* next = child->sibling;
-            child->sibling = reversed;
-            child->parent = nullptr;
-            reversed = child;
-            child = next;
+            node = parent;
+            parent = node->parent;
         }
+        return node;
+    }
 
-        BinomialHeap* temp = new BinomialHeap(mode, analysis);
-        temp->head = reversed;
+    // Unlinks root, adds its children back to the forest and recycles the
+    // node and its handle cell. Any pending roots are folded into the
+    // forest first, the way a Fibonacci heap consolidates on extractMin.
+    void removeRoot(Node* root) {
+        cost.lostTree();  // removing a root
+        count--;
 
-        if (analysis == ACCOUNTING) {
-            totalCredits -= 1;  // removing min root
+        if (roots[root->degree] == root) {
+            rootMask &= ~(1ULL << root->degree);
         }
-        if (analysis == POTENTIAL) {
-            potential -= 1;
+        foldPending(root);
+
+        Node* curr = root->child;
+        while (curr) {
+            cost.step();
+            Node* next = curr->sibling;
+            curr->parent = nullptr;
+            addTree(curr);
+            curr = next;
         }
+        updateMinRoot();
 
-        if (mode == LAZY) {
-            lazyUnion(temp);
-        } else {
-            eagerUnion(temp);
+        handleCells.release(root->handle);
+        pool.release(root);
+    }
+
+    // Runs every live node's destructor, trees and pending roots alike,
+    // with an explicit stack over the child and sibling links. The storage
+    // stays with the pool.
+    void destroyAll() {
+        vector<Node*> stack;
+        for (uint64_t m = rootMask; m; m &= m - 1) stack.push_back(roots[__builtin_ctzll(m)]);
+        for (Node* root = pending; root; root = root->sibling) stack.push_back(root);
+        while (!stack.empty()) {
+            Node* node = stack.back();
+            stack.pop_back();
+            for (Node* child = node->child; child; child = child->sibling) stack.push_back(child);
+            node->~Node();
         }
+        rootMask = 0;
+        pending = minRoot = nullptr;
+        pendingCount = 0;
+        count = 0;
+    }
 
-        printCosts("ExtractMin (removed " + to_string(minNode->key) + ")");
-        return minNode->key;
+    void updateMinRoot() {
+        if constexpr (analysis != NONE) {
+            for (uint64_t m = rootMask; m; m &= m - 1) cost.step();
+        }
+        minRoot = rootMask ? roots[minSlot(rootKeys, rootMask, less)] : nullptr;
     }
 
-    void printCosts(string operation) {
+public:
+    void printCosts(const string& operation) const {
+        HeapStats st = stats();
         cout << "After Operation: " << operation << endl;
-        cout << "Actual Cost so far: " << actualCost << endl;
+        cout << "Actual Cost so far: " << st.actualCost << endl;
         if (analysis == ACCOUNTING) {
-            cout << "Total Credits: " << totalCredits << endl;
-            cout << "Amortized Cost (Accounting Method): " << (actualCost + totalCredits) << endl;
+            cout << "Total Credits: " << st.totalCredits << endl;
+            cout << "Amortized Cost (Accounting Method): " << (st.actualCost + st.totalCredits) << endl;
         } else if (analysis == POTENTIAL) {
-            cout << "Potential: " << potential << endl;
-            cout << "Amortized Cost (Potential Method): " << (actualCost + potential) << endl;
+            cout << "Potential: " << st.potential << endl;
+            cout << "Amortized Cost (Potential Method): " << (st.actualCost + st.potential) << endl;
         }
         cout << "-------------------------------------" << endl;
     }
 
-    void printSummary() {
+    void printSummary() const {
+        HeapStats st = stats();
         cout << "\n========== FINAL SUMMARY ==========\n";
-        cout << "Insert Operations: " << insertCount << endl;
-        cout << "Extract-Min Operations: " << extractMinCount << endl;
-        cout << "Total Actual Cost: " << actualCost << endl;
+        cout << "Insert Operations: " << st.insertCount << endl;
+        cout << "Extract-Min Operations: " << st.extractMinCount << endl;
+        cout << "Decrease-Key Operations: " << st.decreaseKeyCount << endl;
+        cout << "Erase Operations: " << st.eraseCount << endl;
+        cout << "Total Actual Cost: " << st.actualCost << endl;
 
         if (analysis == ACCOUNTING) {
-            cout << "Final Total Credits: " << totalCredits << endl;
-            cout << "Total Amortized Cost (Accounting): " << (actualCost + totalCredits) << endl;
+            cout << "Final Total Credits: " << st.totalCredits << endl;
+            cout << "Total Amortized Cost (Accounting): " << (st.actualCost + st.totalCredits) << endl;
         } else if (analysis == POTENTIAL) {
-            cout << "Final Potential: " << potential << endl;
-            cout << "Total Amortized Cost (Potential): " << (actualCost + potential) << endl;
+            cout << "Final Potential: " << st.potential << endl;
+            cout << "Total Amortized Cost (Potential): " << (st.actualCost + st.potential) << endl;
         }
         cout << "====================================\n";
     }
 };
-int main() {
-    cout << "Using Eager Union + Accounting Method\n\n";
-    BinomialHeap heap(EAGER, ACCOUNTING);
 
-    heap.insert(10);
-    heap.insert(20);
-    heap.insert(5);
-    heap.insert(1);
-    heap.insert(15);
+// Concurrent front-end over one BinomialHeap per worker thread (build with
+// -pthread). Workers are numbered 0..workerCount-1 and pass their number
+// in. Inserts go to the caller's own shard, so they only contend with the
+// occasional extract that samples it. extractMin is relaxed: it pops the
+// smaller minimum of two randomly sampled shards, a near-minimum rather
+// than the exact one. Every rebalanceEvery extracts, a worker evens out
+// two random shards by handing whole trees from the bigger one to the
+// smaller one in O(log n).
+template <typename Key, typename Value = NoValue, typename Compare = less<Key>>
+class ShardedBinomialHeap {
+public:
+    typedef BinomialHeap<Key, Value, Compare> Heap;
+
+private:
+    struct alignas(64) Shard {
+        mutex lock;
+        Heap heap;
+
+        Shard(const Compare& c) : heap(c) {}
+    };
+
+    // Touched only by its own worker
+    struct alignas(64) Worker {
+        uint64_t rng;
+        unsigned extractsSinceRebalance;
+    };
+
+    deque<Shard> shards;        // Built in place: a Shard cannot be moved
+    vector<Worker> workers;
+    unsigned rebalanceEvery;
+    Compare less;
+
+    static unsigned nextRandom(Worker& self) {
+        // xorshift64
+        self.rng ^= self.rng << 13;
+        self.rng ^= self.rng >> 7;
+        self.rng ^= self.rng << 17;
+        return (unsigned)(self.rng >> 32);
+    }
 
-    heap.extractMin();
-    heap.extractMin();
+    void rebalance(Worker& self) {
+        unsigned a = nextRandom(self) % shards.size();
+        unsigned b = nextRandom(self) % shards.size();
+        if (a == b) return;
+
+        std::lock(shards[a].lock, shards[b].lock);
+        lock_guard<mutex> guardA(shards[a].lock, adopt_lock);
+        lock_guard<mutex> guardB(shards[b].lock, adopt_lock);
+        Heap& bigger = shards[a].heap.size() >= shards[b].heap.size() ? shards[a].heap : shards[b].heap;
+        Heap& smaller = &bigger == &shards[a].heap ? shards[b].heap : shards[a].heap;
+        if (bigger.size() > 2 * smaller.size() + 1) {
+            bigger.splitInto(smaller);
+        }
+    }
+
+public:
+    ShardedBinomialHeap(unsigned workerCount, unsigned rebalanceEvery = 64, const Compare& c = Compare())
+        : workers(workerCount), rebalanceEvery(rebalanceEvery), less(c) {
+        for (unsigned i = 0; i < workerCount; i++) {
+            shards.emplace_back(c);
+            workers[i].rng = 0x9E3779B97F4A7C15ULL * (i + 1);
+            workers[i].extractsSinceRebalance = 0;
+        }
+    }
+
+    ShardedBinomialHeap(const ShardedBinomialHeap&) = delete;
+    ShardedBinomialHeap& operator=(const ShardedBinomialHeap&) = delete;
+
+    // splitInto leaves nodes in the slabs of the shard they came from, so
+    // every shard drops its entries before any shard frees its slabs
+    ~ShardedBinomialHeap() {
+        for (Shard& shard : shards) shard.heap.clear();
+    }
+
+    void insert(unsigned worker, const Key& key, const Value& value = Value()) {
+        Shard& shard = shards[worker];
+        lock_guard<mutex> guard(shard.lock);
+        shard.heap.insert(key, value);
+    }
+
+    // Pops a near-minimum entry; false only if every shard was empty
+    bool extractMin(unsigned worker, Key* key = nullptr, Value* value = nullptr) {
+        Worker& self = workers[worker];
+        unsigned n = shards.size();
+        if (++self.extractsSinceRebalance >= rebalanceEvery) {
+            self.extractsSinceRebalance = 0;
+            rebalance(self);
+        }
+
+        for (unsigned attempt = 0; attempt < 2 * n; attempt++) {
+            unsigned a = nextRandom(self) % n;
+            unsigned b = n > 1 ? (a + 1 + nextRandom(self) % (n - 1)) % n : a;
+
+            unique_lock<mutex> lockA(shards[a].lock, try_to_lock);
+            if (!lockA) continue;
+            Heap* best = shards[a].heap.empty() ? nullptr : &shards[a].heap;
+
+            unique_lock<mutex> lockB;
+            if (b != a) {
+                lockB = unique_lock<mutex>(shards[b].lock, try_to_lock);
+                Heap& other = shards[b].heap;
+                if (lockB && !other.empty() && (!best || less(other.findMin(), best->findMin()))) {
+                    best = &other;
+                }
+            }
+            if (best) {
+                best->extractMin(key, value);
+                return true;
+            }
+        }
+
+        // Sampling kept missing: sweep every shard so "empty" is exact
+        for (unsigned i = 0; i < n; i++) {
+            lock_guard<mutex> guard(shards[i].lock);
+            if (shards[i].heap.extractMin(key, value)) return true;
+        }
+        return false;
+    }
+
+    size_t size() {
+        size_t total = 0;
+        for (Shard& shard : shards) {
+            lock_guard<mutex> guard(shard.lock);
+            total += shard.heap.size();
+        }
+        return total;
+    }
+};
+
+// ADAPTIVE against both fixed union policies, see adaptive-benchmark.h
+void benchmarkAdaptive() {
+    runAdaptiveBenchmark([] { return BinomialHeap<int, NoValue, less<int>, LazyUnion>(); },
+                         [] { return BinomialHeap<int, NoValue, less<int>, EagerUnion>(); },
+                         [] { return BinomialHeap<int, NoValue, less<int>, AdaptiveUnion<>>(); });
+}
+
+// Melds many small eager heaps into one large heap and compares that with
+// inserting the same keys one at a time. Only the melds and the insert loop
+// are timed.
+void benchmarkMeld() {
+    typedef BinomialHeap<int> Heap;
+    const int bigSize = 1 << 20;
+    const int smallHeaps = 100000;
+
+    cout << "Meld benchmark: " << smallHeaps << " small heaps into a heap of " << bigSize << " keys\n";
+    for (int smallSize : {1, 3, 7, 15}) {
+        Heap big, reference;
+        vector<Heap> small(smallHeaps);
+
+        for (int i = 0; i < bigSize; i++) {
+            big.insert((int)(i * 7919LL % bigSize));
+            reference.insert((int)(i * 7919LL % bigSize));
+        }
+        for (int i = 0; i < smallHeaps; i++) {
+            for (int j = 0; j < smallSize; j++) {
+                small[i].insert((int)((i * smallSize + j) * 104729LL % bigSize));
+            }
+        }
+
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < smallHeaps; i++) {
+            big.meld(small[i]);
+        }
+        auto meldTime = chrono::steady_clock::now() - start;
+
+        start = chrono::steady_clock::now();
+        for (int i = 0; i < smallHeaps; i++) {
+            for (int j = 0; j < smallSize; j++) {
+                reference.insert((int)((i * smallSize + j) * 104729LL % bigSize));
+            }
+        }
+        auto insertTime = chrono::steady_clock::now() - start;
+
+        cout << "  " << smallSize << " keys per heap: meld "
+             << chrono::duration<double, nano>(meldTime).count() / smallHeaps << " ns/heap, insert loop "
+             << chrono::duration<double, nano>(insertTime).count() / smallHeaps << " ns/heap\n";
+    }
+}
+
+// Bulk build against n single inserts on the same shuffled keys
+void benchmarkBuild() {
+    typedef BinomialHeap<int> Heap;
+
+    cout << "Build benchmark\n";
+    for (int n : {1000000, 10000000}) {
+        vector<int> keys(n);
+        for (int i = 0; i < n; i++) keys[i] = i;
+        shuffle(keys.begin(), keys.end(), mt19937(n));
+
+        double buildTime, insertTime;
+        {
+            Heap heap;
+            auto start = chrono::steady_clock::now();
+            heap.build(keys.begin(), keys.end());
+            buildTime = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            if (heap.findMin() != 0) cout << "  build lost the minimum!\n";
+        }
+        {
+            Heap heap;
+            auto start = chrono::steady_clock::now();
+            for (int key : keys) heap.insert(key);
+            insertTime = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        }
+
+        cout << "  n = " << n << ": build " << buildTime << " ms, " << n << " inserts "
+             << insertTime << " ms (" << insertTime / buildTime << "x)\n";
+    }
+}
+
+// Steady-state drain/refill in batches, batched calls against the same
+// work done one operation at a time, for a cache-resident and a
+// memory-bound heap
+void benchmarkBatch() {
+    typedef BinomialHeap<int> Heap;
+    const int itemsPerRun = 1 << 22;
+
+    cout << "Batch benchmark: " << itemsPerRun << " items popped and pushed\n";
+    for (int heapSize : {1 << 14, 1 << 20}) {
+        mt19937 rng(42);
+        vector<int> keys(heapSize);
+        for (int& key : keys) key = (int)(rng() >> 2);
+
+        for (int batch : {64, 256, 1024}) {
+            vector<int> out(batch), in(batch);
+            double seconds[2];
+
+            for (int batched = 0; batched < 2; batched++) {
+                Heap heap;
+                heap.build(keys.begin(), keys.end());
+                mt19937 fill(batch);
+
+                auto start = chrono::steady_clock::now();
+                for (int done = 0; done < itemsPerRun; done += batch) {
+                    if (batched) {
+                        heap.extractK(batch, out.data());
+                    } else {
+                        for (int i = 0; i < batch; i++) heap.extractMin(&out[i]);
+                    }
+                    // Refill above the popped keys, as a scheduler pushes later deadlines
+                    for (int i = 0; i < batch; i++) in[i] = out[i] + (int)(fill() >> 8);
+                    if (batched) {
+                        heap.insertBatch(in.data(), batch);
+                    } else {
+                        for (int i = 0; i < batch; i++) heap.insert(in[i]);
+                    }
+                }
+                seconds[batched] = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            }
+
+            cout << "  heap " << heapSize << ", batch " << batch << ": single ops "
+                 << 2 * itemsPerRun / seconds[0] / 1e6 << " M ops/s, batched "
+                 << 2 * itemsPerRun / seconds[1] / 1e6 << " M ops/s\n";
+        }
+    }
+}
+
+// Throughput of ShardedBinomialHeap from one thread up to maxThreads
+// (every core by default), then how far its relaxed pops land from the
+// true minimum
+void benchmarkSharded(unsigned maxThreads) {
+    typedef ShardedBinomialHeap<int> Queue;
+    const int prefill = 1 << 16;
+    const int opsPerThread = 1 << 20;
+    const int keyRange = 1 << 20;
+
+    vector<unsigned> threadCounts;
+    for (unsigned threads = 1; threads < maxThreads; threads *= 2) threadCounts.push_back(threads);
+    threadCounts.push_back(maxThreads);
+
+    cout << "Sharded benchmark: " << opsPerThread << " ops per thread, half inserts, half extracts\n";
+    for (unsigned threads : threadCounts) {
+        Queue queue(threads);
+        for (unsigned w = 0; w < threads; w++) {
+            for (int i = 0; i < prefill; i++) queue.insert(w, (int)((i * 7919LL + w) % keyRange));
+        }
+
+        vector<thread> pool;
+        auto start = chrono::steady_clock::now();
+        for (unsigned w = 0; w < threads; w++) {
+            pool.emplace_back([&queue, w]() {
+                mt19937 rng(w);
+                int key;
+                for (int i = 0; i < opsPerThread; i += 2) {
+                    queue.insert(w, (int)(rng() % keyRange));
+                    queue.extractMin(w, &key);
+                }
+            });
+        }
+        for (thread& t : pool) t.join();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        cout << "  " << threads << " threads: " << threads * (double)opsPerThread / seconds / 1e6 << " M ops/s\n";
+    }
+
+    // Rank error, replayed on one thread so the true rank of every popped
+    // key can be read off a Fenwick tree of the keys currently queued
+    cout << "Rank error of popped keys (0 = true minimum)\n";
+    for (unsigned shardCount : {1u, 2u, 4u, 8u, 16u}) {
+        Queue queue(shardCount);
+        vector<int> fenwick(keyRange + 1, 0);
+        auto add = [&fenwick](int key, int delta) {
+            for (int i = key + 1; i <= keyRange; i += i & -i) fenwick[i] += delta;
+        };
+        auto smaller = [&fenwick](int key) {
+            int total = 0;
+            for (int i = key; i > 0; i -= i & -i) total += fenwick[i];
+            return total;
+        };
+
+        mt19937 rng(7);
+        for (int i = 0; i < prefill; i++) {
+            int key = (int)(rng() % keyRange);
+            queue.insert(i % shardCount, key);
+            add(key, 1);
+        }
+
+        double totalError = 0;
+        int maxError = 0;
+        const int pops = 1 << 18;
+        for (int i = 0; i < pops; i++) {
+            unsigned worker = i % shardCount;
+            int key = (int)(rng() % keyRange);
+            queue.insert(worker, key);
+            add(key, 1);
+
+            queue.extractMin(worker, &key);
+            int error = smaller(key);
+            add(key, -1);
+            totalError += error;
+            maxError = max(maxError, error);
+        }
+        cout << "  " << shardCount << " shards: mean " << totalError / pops << ", max " << maxError << "\n";
+    }
+}
+
+// Five inserts and two extract-mins, reporting costs after each one
+template <typename Heap>
+void runDemo(Heap& heap) {
+    for (int key : {10, 20, 5, 1, 15}) {
+        heap.insert(key);
+        heap.printCosts("Insert " + to_string(key));
+    }
+
+    for (int i = 0; i < 2; i++) {
+        int key = 0;
+        heap.extractMin(&key);
+        heap.printCosts("ExtractMin (removed " + to_string(key) + ")");
+    }
 
     heap.printSummary();
+}
 
-    cout << "\nUsing Lazy Union + Potential Method\n\n";
-    BinomialHeap heap2(LAZY, POTENTIAL);
+}  // namespace binomial
+
+#ifndef NO_DEMO_MAIN
+using namespace binomial;
 
-    heap2.insert(10);
-    heap2.insert(20);
-    heap2.insert(5);
-    heap2.insert(1);
-    heap2.insert(15);
+int main(int argc, char* argv[]) {
+    // "bench" runs every benchmark, "bench <name>" just one of them;
+    // "bench sharded <threads>" overrides the core count
+    if (argc > 1 && string(argv[1]) == "bench") {
+        string which = argc > 2 ? argv[2] : "";
+        unsigned maxThreads = argc > 3 ? stoi(argv[3]) : max(1u, thread::hardware_concurrency());
+        if (which.empty() || which == "meld") benchmarkMeld();
+        if (which.empty() || which == "build") benchmarkBuild();
+        if (which.empty() || which == "batch") benchmarkBatch();
+        if (which.empty() || which == "sharded") benchmarkSharded(maxThreads);
+        if (which.empty() || which == "adaptive") benchmarkAdaptive();
+        return 0;
+    }
 
-    heap2.extractMin();
-    heap2.extractMin();
+    cout << "Using Eager Union + Accounting Method\n\n";
+    BinomialHeap<int, NoValue, less<int>, EagerUnion, AccountingCost> heap;
+    runDemo(heap);
 
-    heap2.printSummary();
+    cout << "\nUsing Lazy Union + Potential Method\n\n";
+    BinomialHeap<int, NoValue, less<int>, LazyUnion, PotentialCost> heap2;
+    runDemo(heap2);
 
     return 0;
 }
+#endif
 
 /*
 Using Eager Union + Accounting Method
 
 After Operation: Insert 10
-Actual Cost so far: 0
+Actual Cost so far: 1
 Total Credits: 1
-Amortized Cost (Accounting Method): 1
+Amortized Cost (Accounting Method): 2
 -------------------------------------
 After Operation: Insert 20
-Actual Cost so far: 1
+Actual Cost so far: 3
 Total Credits: 1
-Amortized Cost (Accounting Method): 2
+Amortized Cost (Accounting Method): 4
 -------------------------------------
 After Operation: Insert 5
-Actual Cost so far: 2
+Actual Cost so far: 4
 Total Credits: 2
-Amortized Cost (Accounting Method): 4
+Amortized Cost (Accounting Method): 6
 -------------------------------------
 After Operation: Insert 1
-Actual Cost so far: 5
+Actual Cost so far: 7
 Total Credits: 1
-Amortized Cost (Accounting Method): 6
+Amortized Cost (Accounting Method): 8
 -------------------------------------
 After Operation: Insert 15
-Actual Cost so far: 6
+Actual Cost so far: 8
 Total Credits: 2
-Amortized Cost (Accounting Method): 8
+Amortized Cost (Accounting Method): 10
 -------------------------------------
 After Operation: ExtractMin (removed 1)
-Actual Cost so far: 12
+Actual Cost so far: 13
 Total Credits: -1
-Amortized Cost (Accounting Method): 11
+Amortized Cost (Accounting Method): 12
 -------------------------------------
 After Operation: ExtractMin (removed 5)
-Actual Cost so far: 16
+Actual Cost so far: 17
 Total Credits: -2
-Amortized Cost (Accounting Method): 14
+Amortized Cost (Accounting Method): 15
 -------------------------------------
 
 ========== FINAL SUMMARY ==========
 Insert Operations: 5
 Extract-Min Operations: 2
-Total Actual Cost: 16
+Decrease-Key Operations: 0
+Erase Operations: 0
+Total Actual Cost: 17
 Final Total Credits: -2
-Total Amortized Cost (Accounting): 14
+Total Amortized Cost (Accounting): 15
 ====================================
 
 Using Lazy Union + Potential Method
@@ -312,36 +1068,38 @@ Potential: 2
 Amortized Cost (Potential Method): 2
 -------------------------------------
 After Operation: Insert 5
-Actual Cost so far: 1
+Actual Cost so far: 0
 Potential: 3
-Amortized Cost (Potential Method): 4
+Amortized Cost (Potential Method): 3
 -------------------------------------
 After Operation: Insert 1
-Actual Cost so far: 3
+Actual Cost so far: 0
 Potential: 4
-Amortized Cost (Potential Method): 7
+Amortized Cost (Potential Method): 4
 -------------------------------------
 After Operation: Insert 15
-Actual Cost so far: 6
+Actual Cost so far: 0
 Potential: 5
-Amortized Cost (Potential Method): 11
+Amortized Cost (Potential Method): 5
 -------------------------------------
 After Operation: ExtractMin (removed 1)
-Actual Cost so far: 11
-Potential: 4
-Amortized Cost (Potential Method): 15
+Actual Cost so far: 8
+Potential: 1
+Amortized Cost (Potential Method): 9
 -------------------------------------
 After Operation: ExtractMin (removed 5)
-Actual Cost so far: 15
-Potential: 3
-Amortized Cost (Potential Method): 18
+Actual Cost so far: 12
+Potential: 0
+Amortized Cost (Potential Method): 12
 -------------------------------------
 
 ========== FINAL SUMMARY ==========
 Insert Operations: 5
 Extract-Min Operations: 2
-Total Actual Cost: 15
-Final Potential: 3
-Total Amortized Cost (Potential): 18
+Decrease-Key Operations: 0
+Erase Operations: 0
+Total Actual Cost: 12
+Final Potential: 0
+Total Amortized Cost (Potential): 12
 ====================================
 */
\ No newline at end of file
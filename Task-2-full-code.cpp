@@ -1,7 +1,21 @@
 #include <iostream>
 #include <queue>
+#include <cstdint>
 using namespace std;
 
+// Cost counters read on demand through ExtendedPerfectBinaryTree::stats()
+struct TreeStats {
+    uint64_t insertCount = 0;
+    uint64_t extractMinCount = 0;
+    uint64_t totalRealCost = 0;
+    int64_t potential = 0;              // Number of non-empty nodes
+    int64_t credits = 0;                // Accounting method balance
+
+    int64_t lastRealCost = 0;           // Most recent operation
+    int64_t lastAmortizedPotential = 0;
+    int64_t lastAmortizedAccounting = 0;
+};
+
 struct Node {
     int key;
     bool empty;
@@ -14,15 +28,10 @@ struct Node {
 class ExtendedPerfectBinaryTree {
 public:
     Node* root;
-    int potential; // Potential = number of non-empty nodes
-    int realCost;
-    int credits; // For Accounting method
+    TreeStats st;
 
     ExtendedPerfectBinaryTree() {
         root = nullptr;
-        potential = 0;
-        realCost = 0;
-        credits = 0;
     }
 
     // Manually build initial tree
@@ -43,7 +52,7 @@ public:
         root->left->right->left->right = new Node(16);
         root->left->right->right->left = new Node(18);
         root->left->right->right->right = new Node(29);
-        potential = 15;
+        st.potential = 15;
     }
 
     // Helper for level order insertion (BFS)
@@ -63,8 +72,8 @@ public:
     }
 
     void insert(int key) {
-        realCost = 0; // reset real cost
-        int oldPotential = potential;
+        int64_t realCost = 0;
+        int64_t oldPotential = st.potential;
 
         Node* newNode = new Node(key);
         if (!root) {
@@ -74,24 +83,23 @@ public:
             if (!parent->left) parent->left = newNode;
             else if (!parent->right) parent->right = newNode;
         }
-        potential++;
+        st.potential++;
         realCost += 1; // count insertion as 1 real work
 
-        int deltaPotential = potential - oldPotential;
-        int amortizedPotential = realCost + deltaPotential;
-        int amortizedAccounting = realCost - credits; // using credits if available
+        int64_t deltaPotential = st.potential - oldPotential;
+        int64_t amortizedPotential = realCost + deltaPotential;
+        int64_t amortizedAccounting = realCost - st.credits; // using credits if available
 
-        credits += amortizedPotential - realCost; // add surplus into credits
+        st.credits += amortizedPotential - realCost; // add surplus into credits
 
-        cout << "\n--- Inserted " << key << " ---\n";
-        printTree();
-        printAmortizedSummary(realCost, amortizedPotential, amortizedAccounting);
+        st.insertCount++;
+        recordOperation(realCost, amortizedPotential, amortizedAccounting);
     }
 
     void extractMin() {
-        realCost = 0;
+        int64_t realCost = 0;
         if (!root || root->empty) return;
-        int oldPotential = potential;
+        int64_t oldPotential = st.potential;
 
         Node* x = root;
 
@@ -121,17 +129,29 @@ public:
             }
         }
         x->empty = true;
-        potential--;
+        st.potential--;
+
+        int64_t deltaPotential = st.potential - oldPotential;
+        int64_t amortizedPotential = realCost + deltaPotential;
+        int64_t amortizedAccounting = realCost - st.credits;
 
-        int deltaPotential = potential - oldPotential;
-        int amortizedPotential = realCost + deltaPotential;
-        int amortizedAccounting = realCost - credits;
+        st.credits += amortizedPotential - realCost;
+
+        st.extractMinCount++;
+        recordOperation(realCost, amortizedPotential, amortizedAccounting);
+    }
 
-        credits += amortizedPotential - realCost;
+    // Keeps the costs of the last operation for printAmortizedSummary;
+    // operations themselves never print
+    void recordOperation(int64_t realCost, int64_t amortizedPotential, int64_t amortizedAccounting) {
+        st.totalRealCost += realCost;
+        st.lastRealCost = realCost;
+        st.lastAmortizedPotential = amortizedPotential;
+        st.lastAmortizedAccounting = amortizedAccounting;
+    }
 
-        cout << "\n--- After Extract-Min ---\n";
-        printTree();
-        printAmortizedSummary(realCost, amortizedPotential, amortizedAccounting);
+    const TreeStats& stats() const {
+        return st;
     }
 
     void printTree() {
@@ -155,19 +175,33 @@ public:
             }
             cout << endl;
         }
-        cout << "Current Potential (non-empty nodes): " << potential << endl;
-        cout << "Credits (Accounting Method): " << credits << endl;
+        cout << "Current Potential (non-empty nodes): " << st.potential << endl;
+        cout << "Credits (Accounting Method): " << st.credits << endl;
         cout << "--------------------------------------------------------" << endl;
     }
 
-    void printAmortizedSummary(int realCost, int amortizedPotential, int amortizedAccounting) {
-        cout << "Real Cost: " << realCost << endl;
-        cout << "Amortized Cost (Potential Method): " << amortizedPotential << endl;
-        cout << "Amortized Cost (Accounting Method): " << realCost + (credits) << endl;
+    void printAmortizedSummary() {
+        cout << "Real Cost: " << st.lastRealCost << endl;
+        cout << "Amortized Cost (Potential Method): " << st.lastAmortizedPotential << endl;
+        cout << "Amortized Cost (Accounting Method): " << st.lastRealCost + (st.credits) << endl;
         cout << "--------------------------------------------------------" << endl;
     }
 };
 
+void reportInsert(ExtendedPerfectBinaryTree& tree, int key) {
+    tree.insert(key);
+    cout << "\n--- Inserted " << key << " ---\n";
+    tree.printTree();
+    tree.printAmortizedSummary();
+}
+
+void reportExtractMin(ExtendedPerfectBinaryTree& tree) {
+    tree.extractMin();
+    cout << "\n--- After Extract-Min ---\n";
+    tree.printTree();
+    tree.printAmortizedSummary();
+}
+
 int main() {
     ExtendedPerfectBinaryTree T4;
     T4.buildInitialTree();
@@ -176,21 +210,21 @@ int main() {
     T4.printTree();
 
     // Insert a few elements
-    T4.insert(13);
-    T4.insert(11);
+    reportInsert(T4, 13);
+    reportInsert(T4, 11);
 
     // Extract-Min a few times
-    T4.extractMin();
-    T4.extractMin();
-    T4.extractMin();
-    T4.extractMin();
+    reportExtractMin(T4);
+    reportExtractMin(T4);
+    reportExtractMin(T4);
+    reportExtractMin(T4);
 
     // Insert again
-    T4.insert(6);
-    T4.insert(9);
+    reportInsert(T4, 6);
+    reportInsert(T4, 9);
 
     // Extract again
-    T4.extractMin();
+    reportExtractMin(T4);
 
     return 0;
 }
@@ -0,0 +1,56 @@
+#ifndef ADAPTIVE_BENCHMARK_H
+#define ADAPTIVE_BENCHMARK_H
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+// "bench adaptive" for the binomial and Fibonacci programs. Each heap
+// factory returns a fresh empty heap under one union mode; the heaps only
+// need insert, meld and extractMin.
+
+// One workload under one union mode. Each operation is an insert, a meld
+// of a fresh 8-key heap or an extractMin, drawn with the given
+// percentages, after prefilling the heap. Returns milliseconds.
+template <typename MakeHeap>
+double adaptiveRun(MakeHeap makeHeap, int prefill, int ops, int insertPct, int meldPct) {
+    std::mt19937 rng(ops);
+    auto heap = makeHeap();
+    auto side = makeHeap();
+    for (int i = 0; i < prefill; i++) heap.insert((int)(rng() >> 2));
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ops; i++) {
+        int pick = rng() % 100;
+        if (pick < insertPct) {
+            heap.insert((int)(rng() >> 2));
+        } else if (pick < insertPct + meldPct) {
+            for (int j = 0; j < 8; j++) side.insert((int)(rng() >> 2));
+            heap.meld(side);
+        } else {
+            heap.extractMin();
+        }
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// ADAPTIVE against both fixed union modes on insert-heavy, extract-heavy
+// and mixed workloads
+template <typename MakeLazy, typename MakeEager, typename MakeAdaptive>
+void runAdaptiveBenchmark(MakeLazy lazy, MakeEager eager, MakeAdaptive adaptive) {
+    const int ops = 2000000;
+    struct Workload {
+        const char* name;
+        int prefill, insertPct, meldPct;
+    };
+
+    std::cout << "Adaptive benchmark: " << ops << " operations per workload\n";
+    for (Workload w : {Workload{"insert-heavy", 0, 80, 10}, Workload{"extract-heavy", 4000000, 5, 5},
+                       Workload{"mixed", 100000, 35, 15}}) {
+        std::cout << "  " << w.name << ": lazy " << adaptiveRun(lazy, w.prefill, ops, w.insertPct, w.meldPct)
+                  << " ms, eager " << adaptiveRun(eager, w.prefill, ops, w.insertPct, w.meldPct)
+                  << " ms, adaptive " << adaptiveRun(adaptive, w.prefill, ops, w.insertPct, w.meldPct) << " ms\n";
+    }
+}
+
+#endif
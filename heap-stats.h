@@ -0,0 +1,25 @@
+#ifndef HEAP_STATS_H
+#define HEAP_STATS_H
+
+#include <cstdint>
+
+// Shared by BinomialHeap, FibonacciHeap and PairingHeap.
+//
+// Counters read on demand through each heap's stats(). Reporting is
+// opt-in: operations never print, callers decide when. Everything is
+// 64-bit so long production runs cannot wrap them.
+struct HeapStats {
+    uint64_t actualCost = 0;    // Raw step count
+    int64_t totalCredits = 0;   // Accounting
+    int64_t potential = 0;      // Potential
+
+    uint64_t insertCount = 0;
+    uint64_t extractMinCount = 0;
+    uint64_t decreaseKeyCount = 0;
+    uint64_t eraseCount = 0;
+};
+
+// Payload type for heaps that only order keys
+struct NoValue {};
+
+#endif
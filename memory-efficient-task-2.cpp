@@ -4,274 +4,758 @@
 #include <climits>
 #include <cmath>
 #include <algorithm>
+#include <cstdint>
+#include <string>
+#include <chrono>
+#include <random>
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
 using namespace std;
 
-struct PBTNode {
-    int key;
-    bool empty;
-    PBTNode* left;
-    PBTNode* right;
-    
-    PBTNode(int _key = INT_MAX, bool _empty = true) 
-        : key(_key), empty(_empty), left(nullptr), right(nullptr) {}
+// Also built into Graph-Benchmark.cpp, without main (NO_DEMO_MAIN)
+namespace pbt {
+
+// Keys can be anything below EMPTY, which marks a vacated slot
+const int EMPTY = INT_MAX;
+
+// Tree arrays start on a cache line so a layout can line its blocks up
+// with them
+template <typename T>
+struct CacheAlignedAllocator {
+    typedef T value_type;
+
+    CacheAlignedAllocator() {}
+    template <typename U>
+    CacheAlignedAllocator(const CacheAlignedAllocator<U>&) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(::operator new(n * sizeof(T), align_val_t(64))); }
+    void deallocate(T* p, size_t) { ::operator delete(p, align_val_t(64)); }
+
+    bool operator==(const CacheAlignedAllocator&) const { return true; }
+    bool operator!=(const CacheAlignedAllocator&) const { return false; }
+};
+
+// Layouts map the nodes of a perfect tree of a given height onto array
+// slots. Each one names its arity, the root, the first of a slot's
+// children, which sit in arity consecutive slots (false at the bottom
+// level), the slot of the pos-th node on a level, and the j-th node in
+// array order. A parent always sits before its children, so any prefix of
+// the nodes in array order is a valid heap shape.
+
+// Plain level order: the children of slot i are 2i + 1 and 2i + 2
+struct LevelOrder {
+    static const int arity = 2;
+    size_t size;    // Array length
+
+    LevelOrder(int height = 0) : size(((size_t)1 << height) - 1) {}
+
+    size_t root() const { return 0; }
+
+    bool children(size_t slot, size_t& first) const {
+        first = 2 * slot + 1;
+        return first < size;
+    }
+
+    size_t slot(int depth, size_t pos) const { return ((size_t)1 << depth) - 1 + pos; }
+    size_t nth(size_t j) const { return j; }
+};
+
+// B-heap layout after Kamp: below a top block, the tree is cut into
+// pairs of sibling subtrees of height 3, each pair packed into one
+// 64-byte block of 16 ints with the two roots in slots 2 and 3 and slots
+// 0 and 1 as padding. Both children of a node then always share a cache
+// line, so a pull-up reads one line per three levels. The top block holds
+// the root and the 1-4 leftover levels, rooted low enough that its bottom
+// row still starts at slot 8, so every block steps alike: slot i has
+// children 2i and 2i + 1 up to the bottom row, and bottom-row slot i of
+// block b roots the pair in block i - 7 for the top block and
+// fanout + 8b - 15 + i below it.
+struct BlockedLayout {
+    static const int arity = 2;
+    int top;            // Levels held by the top block
+    size_t fanout;      // Child blocks of the top block, 2^(top - 1)
+    size_t blocks;
+    size_t size;
+
+    BlockedLayout(int height = 0) {
+        top = height > 1 ? height - 3 * ((height - 2) / 3) : height;
+        fanout = top ? (size_t)1 << (top - 1) : 0;
+        blocks = 0;
+        if (height) {
+            size_t below = ((size_t)1 << (height - top)) - 1;      // 8^k - 1
+            blocks = 1 + fanout * (below / 7);
+        }
+        size = 16 * blocks;
+    }
+
+    size_t root() const { return 16 >> top; }
+
+    bool children(size_t slot, size_t& first) const {
+        size_t i = slot & 15;
+        if (i < 8) {
+            first = slot + i;
+            return true;
+        }
+        size_t block = slot >> 4;
+        size_t child = block ? fanout + 8 * block - 15 + i : i - 7;
+        first = 16 * child + 2;
+        return child < blocks;
+    }
+
+    size_t slot(int depth, size_t pos) const {
+        if (depth < top) return (root() << depth) + pos;
+        int level = (depth - top) / 3, inner = (depth - top) % 3 + 1;
+        size_t levelStart = 1 + fanout * ((((size_t)1 << (3 * level)) - 1) / 7);
+        size_t block = levelStart + (pos >> inner);
+        return 16 * block + ((size_t)1 << inner) + (pos & (((size_t)1 << inner) - 1));
+    }
+
+    size_t nth(size_t j) const {
+        size_t topNodes = 2 * fanout - 1;
+        if (j < topNodes) {
+            int depth = 31 - __builtin_clz(j + 1);
+            return (root() << depth) + j + 1 - ((size_t)1 << depth);
+        }
+        j -= topNodes;
+        return 16 * (1 + j / 14) + j % 14 + 2;
+    }
+};
+
+// D-ary level order (D = 4, 8 or 16) after D - 1 padding slots. The
+// padding puts every group of siblings on a multiple of D ints, so a
+// pull-up step is one minChild() over them: the root is slot D - 1 and
+// the children of slot s are D(s + 2 - D) onwards. The trees are log2(D)
+// times shallower than binary ones.
+template <int D>
+struct DaryLevelOrder {
+    static_assert(D >= 2 && D <= 16 && (D & (D - 1)) == 0, "D must be a power of two up to 16");
+
+    static const int arity = D;
+    size_t size;
+
+    DaryLevelOrder(int height = 0) : size(height ? D - 1 + levelStart(height) : 0) {}
+
+    // Nodes above the given depth, (D^depth - 1) / (D - 1)
+    static size_t levelStart(int depth) { return (((size_t)1 << (__builtin_ctz(D) * depth)) - 1) / (D - 1); }
+
+    size_t root() const { return D - 1; }
+
+    bool children(size_t slot, size_t& first) const {
+        first = D * (slot + 2 - D);
+        return first < size;
+    }
+
+    size_t slot(int depth, size_t pos) const { return D - 1 + levelStart(depth) + pos; }
+    size_t nth(size_t j) const { return D - 1 + j; }
+};
+
+// Index of the smallest of the D keys at keys[0 .. D), the lowest one on
+// ties. keys must sit on a multiple of D ints (at most 16). Built with
+// -mavx2, -msse4.1 or -march=native this is a vector min, one compare
+// against the broadcast minimum and a movemask, with no branch on the
+// keys; otherwise a plain scan.
+template <int D>
+inline int minChild(const int* keys) {
+#if defined(__AVX2__)
+    if constexpr (D % 8 == 0) {
+        __m256i m = _mm256_load_si256((const __m256i*)keys);
+        for (int i = 8; i < D; i += 8) m = _mm256_min_epi32(m, _mm256_load_si256((const __m256i*)(keys + i)));
+        __m128i v = _mm_min_epi32(_mm256_castsi256_si128(m), _mm256_extracti128_si256(m, 1));
+        v = _mm_min_epi32(v, _mm_shuffle_epi32(v, 0x4E));
+        v = _mm_min_epi32(v, _mm_shuffle_epi32(v, 0xB1));
+        __m256i target = _mm256_broadcastd_epi32(v);
+        unsigned hits = 0;
+        for (int i = 0; i < D; i += 8) {
+            __m256i eq = _mm256_cmpeq_epi32(_mm256_load_si256((const __m256i*)(keys + i)), target);
+            hits |= (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(eq)) << i;
+        }
+        return __builtin_ctz(hits);
+    }
+#endif
+#if defined(__SSE4_1__)
+    if constexpr (D % 4 == 0) {
+        __m128i v = _mm_load_si128((const __m128i*)keys);
+        for (int i = 4; i < D; i += 4) v = _mm_min_epi32(v, _mm_load_si128((const __m128i*)(keys + i)));
+        v = _mm_min_epi32(v, _mm_shuffle_epi32(v, 0x4E));
+        v = _mm_min_epi32(v, _mm_shuffle_epi32(v, 0xB1));
+        unsigned hits = 0;
+        for (int i = 0; i < D; i += 4) {
+            __m128i eq = _mm_cmpeq_epi32(_mm_load_si128((const __m128i*)(keys + i)), v);
+            hits |= (unsigned)_mm_movemask_ps(_mm_castsi128_ps(eq)) << i;
+        }
+        return __builtin_ctz(hits);
+    }
+#endif
+    int best = 0;
+    for (int i = 1; i < D; i++) {
+        if (keys[i] < keys[best]) best = i;
+    }
+    return best;
+}
+
+// A perfect tree of height k holds (D^k - 1) / (D - 1) keys, D the
+// layout's arity, in an array arranged by Layout, so no node is ever
+// allocated. emptyCount tracks the EMPTY nodes so nothing ever has to
+// recount them; padding slots also hold EMPTY but are not nodes.
+template <typename Layout>
+struct PerfectTree {
+    static const int LOG_D = __builtin_ctz(Layout::arity);
+
+    int height;
+    Layout layout;
+    vector<int, CacheAlignedAllocator<int>> keys;
+    int emptyCount;
+
+    PerfectTree(int _height = 0)
+        : height(_height), layout(_height), keys(layout.size, EMPTY), emptyCount(nodes()) {}
+
+    static size_t nodesAt(int height) { return (((size_t)1 << (LOG_D * height)) - 1) / (Layout::arity - 1); }
+    size_t nodes() const { return nodesAt(height); }
+    int& rootKey() { return keys[layout.root()]; }
+    int rootKey() const { return keys[layout.root()]; }
 };
 
-class PerfectBinaryHeap {
+// Cost counters read on demand through PerfectHeap::stats()
+struct HeapStats {
+    uint64_t operationCount = 0;
+    uint64_t insertCount = 0;
+    uint64_t unionCount = 0;
+    uint64_t findMinCount = 0;
+    uint64_t extractMinCount = 0;
+    uint64_t rebuildCount = 0;
+
+    uint64_t actualCost = 0;            // Totals over all operations
+    int64_t amortizedPotential = 0;
+    int64_t amortizedAccounting = 0;
+    int64_t potential = 0;              // Total emptyCount over the trees
+    int64_t credits = 0;                // Accounting method balance
+
+    int64_t lastActual = 0;             // Most recent operation
+    int64_t lastAmortizedPotential = 0;
+    int64_t lastAmortizedAccounting = 0;
+};
+
+// Perfect heap whose trees have Layout's arity D: binary for LevelOrder
+// and BlockedLayout, D-ary for DaryLevelOrder<D>. Trees of equal height
+// are linked D at a time, so the forest is a base-D counter.
+template <typename Layout = LevelOrder>
+class PerfectHeap {
 private:
-    vector<PBTNode*> trees;  // Eager union: array of tree pointers
-    int totalNodes;
-    int potential;          // For potential method analysis
-    int credits;            // For accounting method analysis
-    
-    // Build a perfect tree of height k
-    PBTNode* buildTree(int k, int val = INT_MAX) {
-        if (k == 0) return nullptr;
-        PBTNode* node = new PBTNode(val, val == INT_MAX);
-        node->left = buildTree(k-1, val);
-        node->right = buildTree(k-1, val);
-        return node;
+    typedef PerfectTree<Layout> Tree;
+
+    static const int D = Layout::arity;
+    static const int LOG_D = Tree::LOG_D;
+    static const int MAX_HEIGHT = 32;
+
+    // trees[h] holds up to D - 1 trees of height h; bit h of heightMask is
+    // set while it holds any
+    vector<Tree> trees[MAX_HEIGHT];
+    uint32_t heightMask;
+    int minHeight, minIndex;    // Tree with the smallest root, minHeight -1 when empty
+    int totalNodes;             // Keys held
+    double emptyFraction;       // Rebuild threshold, see the constructor
+    HeapStats st;
+
+    // Slot of the smallest of the D children at first. The binary case
+    // stays a branch rather than an index computed from the compare: a
+    // predicted branch starts the next level's loads early, which more
+    // than halves the pull-up time on trees far beyond cache.
+    static size_t smallestChild(const Tree& tree, size_t first) {
+        if constexpr (D == 2) {
+            return tree.keys[first + 1] < tree.keys[first] ? first + 1 : first;
+        } else {
+            return first + minChild<D>(&tree.keys[first]);
+        }
     }
-    
-    // Pull-up implementation for extractMin
-    void pullUp(PBTNode* node) {
-        while (true) {
-            PBTNode* smaller = nullptr;
-            
-            if (node->left && !node->left->empty) {
-                smaller = node->left;
-            }
-            
-            if (node->right && !node->right->empty) {
-                if (!smaller || node->right->key < smaller->key) {
-                    smaller = node->right;
+
+    // Pull-up implementation for extractMin: the smallest child moves into
+    // the hole until the hole reaches a slot whose children are empty.
+    // EMPTY sorts above every key, so an empty child is never chosen.
+    // Returns the keys moved.
+    int pullUp(Tree& tree) {
+        auto& keys = tree.keys;
+        size_t hole = tree.layout.root(), first;
+        int steps = 0;
+        while (tree.layout.children(hole, first)) {
+            size_t child = smallestChild(tree, first);
+            if (keys[child] == EMPTY) break;
+            keys[hole] = keys[child];
+            hole = child;
+            steps++;
+        }
+        keys[hole] = EMPTY;
+        tree.emptyCount++;
+        return steps;
+    }
+
+    // D trees of height h become the subtrees of a new height h + 1 tree,
+    // copied level by level, and the smallest root is pulled up into the
+    // new root. The hole it leaves behind is the one new empty slot.
+    Tree link(vector<Tree>& group) {
+        int height = group[0].height;
+        Tree tree(height + 1);
+        tree.emptyCount = 0;
+        for (int depth = 0; depth < height; depth++) {
+            size_t width = (size_t)1 << (LOG_D * depth);
+            for (int k = 0; k < D; k++) {
+                const Tree& from = group[k];
+                for (size_t pos = 0; pos < width; pos++) {
+                    tree.keys[tree.layout.slot(depth + 1, k * width + pos)] = from.keys[from.layout.slot(depth, pos)];
                 }
             }
-            
-            if (!smaller) break;
-            
-            node->key = smaller->key;
-            node->empty = false;
-            node = smaller;
         }
-        
-        node->empty = true;
-    }
-    
-    // Count empty nodes in a tree
-    int countEmptyNodes(PBTNode* node) {
-        if (!node) return 0;
-        return (node->empty ? 1 : 0) + countEmptyNodes(node->left) + countEmptyNodes(node->right);
+        for (const Tree& from : group) tree.emptyCount += from.emptyCount;
+        pullUp(tree);
+        st.potential++;
+        return tree;
     }
-    
-    // Collect non-empty values from a tree
-    void collectNonEmptyValues(PBTNode* node, vector<int>& values) {
-        if (!node) return;
-        if (!node->empty) {
-            values.push_back(node->key);
+
+    // Base-D counter increment: the D-th tree of a height links with the
+    // other D - 1 and carries upward. Returns the slots copied by the
+    // links, every slot of each new tree but its root.
+    int addTree(Tree tree) {
+        int copied = 0;
+        int h = tree.height;
+        trees[h].push_back(move(tree));
+        while ((int)trees[h].size() == D) {
+            Tree linked = link(trees[h]);
+            trees[h].clear();
+            heightMask &= ~(1u << h);
+            copied += linked.nodes() - 1;
+            trees[++h].push_back(move(linked));
         }
-        collectNonEmptyValues(node->left, values);
-        collectNonEmptyValues(node->right, values);
+        heightMask |= 1u << h;
+        return copied;
     }
-    
-    // Delete a tree
-    void deleteTree(PBTNode* node) {
-        if (!node) return;
-        deleteTree(node->left);
-        deleteTree(node->right);
-        delete node;
+
+    Tree removeTree(int h, int i) {
+        Tree tree = move(trees[h][i]);
+        if (i + 1 < (int)trees[h].size()) trees[h][i] = move(trees[h].back());
+        trees[h].pop_back();
+        if (trees[h].empty()) heightMask &= ~(1u << h);
+        return tree;
     }
-    
-    // Rebuild a tree when too many empty nodes
-    void rebuildTree(int index) {
-        vector<int> values;
-        collectNonEmptyValues(trees[index], values);
-        deleteTree(trees[index]);
-        
-        if (values.empty()) {
-            trees.erase(trees.begin() + index);
-            return;
+
+    // One comparison per tree, at most (D - 1) log_D n of them
+    void updateMin() {
+        minHeight = -1;
+        for (uint32_t m = heightMask; m; m &= m - 1) {
+            int h = __builtin_ctz(m);
+            for (int i = 0; i < (int)trees[h].size(); i++) {
+                if (minHeight < 0 || trees[h][i].rootKey() < trees[minHeight][minIndex].rootKey()) {
+                    minHeight = h;
+                    minIndex = i;
+                }
+            }
         }
-        
-        int newHeight = ceil(log2(values.size() + 1));
-        int treeSize = 1 << newHeight;
-        totalNodes -= (1 << (int)log2(treeSize)) - values.size();
-        
-        int valIndex = 0;
-        trees[index] = buildTree(newHeight);
-        fillTree(trees[index], values, valIndex);
-    }
-    
-    // Fill tree with values
-    void fillTree(PBTNode* node, const vector<int>& values, int& index) {
-        if (!node || index >= values.size()) return;
-        node->key = values[index++];
-        node->empty = false;
-        fillTree(node->left, values, index);
-        fillTree(node->right, values, index);
     }
-    
-    // Update potential function
-    void updatePotential() {
-        potential = 0;
-        for (auto tree : trees) {
-            potential += countEmptyNodes(tree);
+
+    // Sift the key at slot down until all its children are larger.
+    // Returns the levels it moved down.
+    static int siftDown(Tree& tree, size_t slot) {
+        auto& keys = tree.keys;
+        int key = keys[slot];
+        size_t first;
+        int steps = 0;
+        while (tree.layout.children(slot, first)) {
+            size_t child = smallestChild(tree, first);
+            if (key <= keys[child]) break;
+            keys[slot] = keys[child];
+            slot = child;
+            steps++;
         }
+        keys[slot] = key;
+        return steps;
     }
-    
-public:
-    PerfectBinaryHeap() : totalNodes(0), potential(0), credits(0) {}
-    
-    ~PerfectBinaryHeap() {
-        for (auto tree : trees) {
-            deleteTree(tree);
+
+    // Moves the n keys at the front of the array onto the tree's first n
+    // nodes in array order (the j-th node never sits before slot j, so
+    // walking down moves each key once), then restores heap order with a
+    // bottom-up (Floyd) heapify in O(n). Returns the work done: one per
+    // key placed and per node visited, plus the sift steps.
+    static int64_t heapify(Tree& tree, size_t n) {
+        auto& keys = tree.keys;
+        fill(keys.begin() + n, keys.end(), EMPTY);
+        int64_t work = 0;
+        for (size_t j = n; j-- > 0;) {
+            size_t slot = tree.layout.nth(j);
+            if (slot != j) {
+                keys[slot] = keys[j];
+                keys[j] = EMPTY;
+                work++;
+            }
+        }
+        for (size_t j = n; j-- > 0;) {
+            work += 1 + siftDown(tree, tree.layout.nth(j));
         }
+        tree.emptyCount = tree.nodes() - n;
+        return work;
     }
-    
+
+    // Height of the smallest perfect tree that holds n keys
+    static int heightFor(size_t n) {
+        int height = 1;
+        while (Tree::nodesAt(height) < n) height++;
+        return height;
+    }
+
+    // Rebuild a tree when too many empty nodes. The survivors are packed
+    // to the front of the tree's own array, which shrinks to the smallest
+    // perfect tree that holds them and is heapified in place. The tree is
+    // carried back in like an insert. Returns the actual cost: the slots
+    // scanned by the packing, the heapify work and the slots the carry
+    // copies.
+    int64_t rebuildTree(int h, int i) {
+        st.rebuildCount++;
+        Tree tree = removeTree(h, i);
+        st.potential -= tree.emptyCount;
+
+        auto& keys = tree.keys;
+        int64_t work = keys.size();
+        size_t n = remove(keys.begin(), keys.end(), EMPTY) - keys.begin();
+        if (n == 0) return work;
+
+        tree.height = heightFor(n);
+        tree.layout = Layout(tree.height);
+        keys.resize(tree.layout.size);
+        work += heapify(tree, n);
+        st.potential += tree.emptyCount;
+        return work + addTree(move(tree));
+    }
+
+public:
+    // A tree is rebuilt once more than emptyFraction of its slots are
+    // empty. Lower values keep the arrays tight at the price of more
+    // frequent rebuilds; 1 only rebuilds trees that are entirely empty.
+    // Below (D - 1) / D, one half for binary trees, a rebuild could not
+    // shrink the tree, so that is the floor and the default.
+    PerfectHeap(double _emptyFraction = 1 - 1.0 / D)
+        : heightMask(0), minHeight(-1), minIndex(0), totalNodes(0),
+          emptyFraction(max(_emptyFraction, 1 - 1.0 / D)) {}
+
     // Make-Heap operation - O(1)
     void makeHeap() {
         // Nothing to do, constructor already initialized everything
         recordOperation(0, 1, 1); // Actual O(1), amortized O(1)
     }
-    
-    // Insert operation - O(1) amortized
-    void insert(int key) {
-        int oldPotential = potential;
-        
-        // Create new tree of height 0 with this key
-        PBTNode* newTree = new PBTNode(key, false);
-        trees.push_back(newTree);
+
+    // Insert operation - O(log_D n) amortized. A link copies all D
+    // subtrees into the new tree's array, so a slot is copied once for
+    // every level it is carried up, and the copies count as actual cost.
+    // Returns false, leaving the heap alone, if key is EMPTY, which marks
+    // vacated slots.
+    bool insert(int key) {
+        if (key == EMPTY) return false;
+        st.insertCount++;
+        int64_t oldPotential = st.potential;
+
+        // A height 1 tree holding just this key, carried in
+        Tree tree(1);
+        tree.rootKey() = key;
+        tree.emptyCount = 0;
+        int copied = addTree(move(tree));
         totalNodes++;
-        
-        // Update potential and credits
-        updatePotential();
-        int actualCost = 1;
-        int amortizedCost = actualCost + (potential - oldPotential);
-        credits += amortizedCost - actualCost;
-        
-        recordOperation(actualCost, amortizedCost, 2); // Charge 2, 1 for actual cost
+        updateMin();
+
+        // Update credits
+        int actualCost = 1 + copied;
+        int64_t amortizedCost = actualCost + (st.potential - oldPotential);
+        st.credits += amortizedCost - actualCost;
+
+        // Charge 1 for the key and 2 per level for the copies of its slot
+        // and of the root slot the link above it adds
+        recordOperation(actualCost, amortizedCost, 1 + 2 * ceil(log2(totalNodes + 1) / LOG_D));
+
+        return true;
     }
-    
-    // Union operation - O(1) amortized
-    void unionHeap(PerfectBinaryHeap& other) {
-        int oldPotential = potential;
-        
-        // Merge the tree lists - O(1) operation with eager union
-        trees.insert(trees.end(), other.trees.begin(), other.trees.end());
+
+    // Adds the keys in [first, last) in O(n) as one heapified tree instead
+    // of n carries. Returns false, adding nothing, if any key is EMPTY.
+    template <typename KeyIt>
+    bool build(KeyIt first, KeyIt last) {
+        if (find(first, last, EMPTY) != last) return false;
+        size_t n = distance(first, last);
+        if (n == 0) return true;
+        st.insertCount += n;
+        int64_t oldPotential = st.potential;
+
+        Tree tree(heightFor(n));
+        copy(first, last, tree.keys.begin());
+        int64_t work = heapify(tree, n);
+        st.potential += tree.emptyCount;
+        int copied = addTree(move(tree));
+        totalNodes += n;
+        updateMin();
+
+        // Update credits
+        int64_t actualCost = n + work + copied;
+        int64_t amortizedCost = actualCost + (st.potential - oldPotential);
+        st.credits += amortizedCost - actualCost;
+
+        recordOperation(actualCost, amortizedCost, n * (1 + 2 * ceil(log2(totalNodes + 1) / LOG_D)));
+
+        return true;
+    }
+
+    // Union operation - adds the two base-D counters with O(log_D n)
+    // links, paid for by the credits of the keys they copy
+    void unionHeap(PerfectHeap& other) {
+        st.unionCount++;
+        int64_t oldPotential = st.potential;
+
+        // Carry the other heap's trees in, smallest first
+        int copied = 0;
+        st.potential += other.st.potential;
+        for (uint32_t m = other.heightMask; m; m &= m - 1) {
+            int h = __builtin_ctz(m);
+            while (!other.trees[h].empty()) {
+                copied += addTree(other.removeTree(h, other.trees[h].size() - 1));
+            }
+        }
         totalNodes += other.totalNodes;
-        
-        // Clear the other heap without deleting trees
-        other.trees.clear();
+        updateMin();
+
+        // Leave the other heap empty
         other.totalNodes = 0;
-        
-        // Update potential and credits
-        updatePotential();
-        int actualCost = 1;
-        int amortizedCost = actualCost + (potential - oldPotential);
-        credits += amortizedCost - actualCost;
-        
+        other.st.potential = 0;
+        other.minHeight = -1;
+
+        // Update credits
+        int actualCost = 1 + copied;
+        int64_t amortizedCost = actualCost + (st.potential - oldPotential);
+        st.credits += amortizedCost - actualCost;
+
         recordOperation(actualCost, amortizedCost, 1);
     }
-    
-    // Find minimum - O(log n) amortized (due to eager union)
+
+    // Find minimum - O(1) from the cached tree
     int findMin() {
-        int minVal = INT_MAX;
-        for (auto tree : trees) {
-            if (tree && !tree->empty && tree->key < minVal) {
-                minVal = tree->key;
-            }
-        }
-        
-        recordOperation(log2(totalNodes + 1), log2(totalNodes + 1), log2(totalNodes + 1));
-        return minVal;
+        st.findMinCount++;
+        recordOperation(1, 1, 1);
+        return minHeight < 0 ? INT_MAX : trees[minHeight][minIndex].rootKey();
     }
-    
-    // Extract minimum - O(log n) amortized
+
+    // Extract minimum - O(log_D n) amortized
     int extractMin() {
-        if (trees.empty()) return INT_MAX;
-        
-        int oldPotential = potential;
-        
-        // Find tree with minimum root - O(log n) due to eager union
-        int minIndex = -1;
-        int minVal = INT_MAX;
-        for (int i = 0; i < trees.size(); i++) {
-            if (trees[i] && !trees[i]->empty && trees[i]->key < minVal) {
-                minVal = trees[i]->key;
-                minIndex = i;
-            }
-        }
-        
-        if (minIndex == -1) return INT_MAX;
-        
-        // Perform pull-up operation
-        pullUp(trees[minIndex]);
+        if (minHeight < 0 || trees[minHeight][minIndex].rootKey() == EMPTY) return INT_MAX;
+
+        int64_t oldPotential = st.potential;
+        Tree& tree = trees[minHeight][minIndex];
+        int minVal = tree.rootKey();
+        st.extractMinCount++;
+
+        // Perform pull-up operation: the root plus each key moved up
+        int64_t actualCost = 1 + pullUp(tree);
+        st.potential++;
         totalNodes--;
-        
-        // Check if we need to rebuild this tree
-        int emptyCount = countEmptyNodes(trees[minIndex]);
-        int threshold = (1 << ((int)log2(totalNodes + 1) - 1));
-        
-        if (emptyCount >= threshold) {
-            rebuildTree(minIndex);
+
+        // Rebuild once too much of this tree is empty; its work counts as
+        // actual cost too
+        if (tree.emptyCount > emptyFraction * tree.nodes() || tree.emptyCount == (int)tree.nodes()) {
+            actualCost += rebuildTree(minHeight, minIndex);
         }
-        
-        // Update potential and credits
-        updatePotential();
-        int actualCost = log2(totalNodes + 1); // Dominated by pull-up and find tree
-        int amortizedCost = actualCost + (potential - oldPotential);
-        credits += amortizedCost - actualCost;
-        
-        recordOperation(actualCost, amortizedCost, 2 * log2(totalNodes + 1));
-        
+        updateMin();
+
+        // Update credits
+        int64_t amortizedCost = actualCost + (st.potential - oldPotential);
+        st.credits += amortizedCost - actualCost;
+
+        recordOperation(actualCost, amortizedCost, 2 * log2(totalNodes + 1) / LOG_D);
+
         return minVal;
     }
-    
-    // Record operation for analysis
-    void recordOperation(int actual, int amortizedPotential, int amortizedAccounting) {
+
+    // Record operation for analysis; nothing is printed here
+    void recordOperation(int64_t actual, int64_t amortizedPotential, int64_t amortizedAccounting) {
+        st.operationCount++;
+        st.actualCost += actual;
+        st.amortizedPotential += amortizedPotential;
+        st.amortizedAccounting += amortizedAccounting;
+        st.lastActual = actual;
+        st.lastAmortizedPotential = amortizedPotential;
+        st.lastAmortizedAccounting = amortizedAccounting;
+    }
+
+    const HeapStats& stats() const {
+        return st;
+    }
+
+    // Bytes held by the tree arrays, including capacity kept for reuse
+    size_t memoryUsage() const {
+        size_t bytes = 0;
+        for (uint32_t m = heightMask; m; m &= m - 1) {
+            for (const Tree& tree : trees[__builtin_ctz(m)]) bytes += tree.keys.capacity() * sizeof(int);
+        }
+        return bytes;
+    }
+
+    size_t size() const {
+        return totalNodes;
+    }
+
+    // Analysis of the most recent operation, printed on request
+    void printLastOperation() const {
         cout << "Operation Analysis:\n";
-        cout << "  Actual Cost: " << actual << "\n";
-        cout << "  Amortized Cost (Potential Method): " << amortizedPotential << "\n";
-        cout << "  Amortized Cost (Accounting Method): " << amortizedAccounting << "\n";
-        cout << "  Current Potential: " << potential << "\n";
-        cout << "  Current Credits: " << credits << "\n\n";
+        cout << "  Actual Cost: " << st.lastActual << "\n";
+        cout << "  Amortized Cost (Potential Method): " << st.lastAmortizedPotential << "\n";
+        cout << "  Amortized Cost (Accounting Method): " << st.lastAmortizedAccounting << "\n";
+        cout << "  Current Potential: " << st.potential << "\n";
+        cout << "  Current Credits: " << st.credits << "\n\n";
     }
-    
+
     // Print heap for visualization
     void printHeap() {
-        cout << "Perfect Binary Heap Contents (" << trees.size() << " trees):\n";
-        for (int i = 0; i < trees.size(); i++) {
-            cout << "Tree " << i << " (Height " << (int)log2((trees[i] ? 1 : 0) + 1) << "): ";
-            printTree(trees[i]);
-            cout << endl;
+        int count = 0;
+        for (uint32_t m = heightMask; m; m &= m - 1) count += trees[__builtin_ctz(m)].size();
+        cout << "Perfect " << (D == 2 ? string("Binary") : to_string(D) + "-ary")
+             << " Heap Contents (" << count << " trees):\n";
+        int i = 0;
+        for (uint32_t m = heightMask; m; m &= m - 1) {
+            int h = __builtin_ctz(m);
+            for (const Tree& tree : trees[h]) {
+                cout << "Tree " << i++ << " (Height " << h << "): ";
+                printTree(tree, tree.layout.root());
+                cout << endl;
+            }
         }
     }
-    
-    void printTree(PBTNode* node) {
-        if (!node) {
-            cout << "X";
-            return;
-        }
-        if (node->empty) {
+
+    void printTree(const Tree& tree, size_t slot) {
+        if (tree.keys[slot] == EMPTY) {
             cout << "X";
         } else {
-            cout << node->key;
+            cout << tree.keys[slot];
         }
         cout << "(";
-        printTree(node->left);
-        cout << ",";
-        printTree(node->right);
+        size_t first;
+        bool inner = tree.layout.children(slot, first);
+        for (int k = 0; k < D; k++) {
+            if (k) cout << ",";
+            if (inner) {
+                printTree(tree, first + k);
+            } else {
+                cout << "X";
+            }
+        }
         cout << ")";
     }
 };
 
-int main() {
-    PerfectBinaryHeap heap;
+template <typename Layout = LevelOrder>
+using PerfectBinaryHeap = PerfectHeap<Layout>;
+
+template <int D>
+using DaryPerfectHeap = PerfectHeap<DaryLevelOrder<D>>;
+
+// 2^(h-1) inserts link into a single height-h tree that is one key short
+// of half empty, so the first extractMin rebuilds it. Times that extract.
+void benchmarkRebuild() {
+    cout << "Rebuild benchmark: the extractMin that compacts one tree\n";
+    mt19937 rng(1);
+    for (int h = 10; h <= 24; h++) {
+        PerfectBinaryHeap<> heap;
+        for (int i = 0; i < (1 << (h - 1)); i++) heap.insert(rng() >> 2);
+
+        auto start = chrono::steady_clock::now();
+        heap.extractMin();
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        cout << "  height " << h << ": " << ms << " ms, " << ms * 1e6 / heap.size() << " ns/key"
+             << (heap.stats().rebuildCount == 1 ? "" : " (no rebuild)") << "\n";
+    }
+}
+
+// Steady mixed inserts and extracts under each rebuild threshold: total
+// time, rebuilds, and peak array bytes per key
+void benchmarkThreshold() {
+    const int prefill = 1 << 20, ops = 1 << 22;
+    cout << "Threshold benchmark: " << prefill << " keys, " << ops << " mixed operations\n";
+    for (double fraction : {0.5, 0.625, 0.75, 0.875, 1.0}) {
+        mt19937 rng(1);
+        PerfectBinaryHeap<> heap(fraction);
+        for (int i = 0; i < prefill; i++) heap.insert(rng() >> 2);
+
+        size_t peakBytes = 0;
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < ops; i++) {
+            if (rng() & 1) {
+                heap.insert(rng() >> 2);
+            } else {
+                heap.extractMin();
+            }
+            if ((i & 255) == 0) peakBytes = max(peakBytes, heap.memoryUsage());
+        }
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        cout << "  empty fraction " << fraction << ": " << ms << " ms, " << heap.stats().rebuildCount
+             << " rebuilds, " << (double)peakBytes / heap.size() << " peak bytes/key\n";
+    }
+}
+
+// Extract throughput on a single tree built from 2^h - 1 keys. An empty
+// fraction of 1 keeps it from being rebuilt, so every extract is a full
+// pull-up. Returns nanoseconds per extract.
+template <typename Heap>
+double extractRun(int h, int extracts) {
+    mt19937 rng(h);
+    vector<int> keys((1 << h) - 1);
+    for (int& key : keys) key = rng() >> 2;
+    Heap heap(1.0);
+    heap.build(keys.begin(), keys.end());
+    keys = vector<int>();
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < extracts; i++) heap.extractMin();
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / extracts;
+}
+
+// Level order against the blocked layout, up to trees far beyond L3
+void benchmarkLayout() {
+    const int extracts = 1 << 18;
+    cout << "Layout benchmark: " << extracts << " extracts from one tree\n";
+    for (int h : {16, 20, 24, 27}) {
+        double level = extractRun<PerfectBinaryHeap<LevelOrder>>(h, extracts);
+        double blocked = extractRun<PerfectBinaryHeap<BlockedLayout>>(h, extracts);
+        cout << "  height " << h << ": level order " << level << " ns, blocked " << blocked << " ns\n";
+    }
+}
+
+// The binary pull-up against D = 4, 8 and 16 on the same keys
+void benchmarkDary() {
+    const int extracts = 1 << 18;
+    cout << "D-ary benchmark: " << extracts << " extracts from one tree\n";
+    for (int h : {16, 20, 24}) {
+        cout << "  2^" << h << " keys: binary " << extractRun<PerfectBinaryHeap<>>(h, extracts)
+             << " ns, 4-ary " << extractRun<DaryPerfectHeap<4>>(h, extracts)
+             << " ns, 8-ary " << extractRun<DaryPerfectHeap<8>>(h, extracts)
+             << " ns, 16-ary " << extractRun<DaryPerfectHeap<16>>(h, extracts) << " ns\n";
+    }
+}
+
+}  // namespace pbt
+
+#ifndef NO_DEMO_MAIN
+using namespace pbt;
+
+int main(int argc, char* argv[]) {
+    // "bench" runs every benchmark, "bench <name>" just one of them
+    if (argc > 1 && string(argv[1]) == "bench") {
+        string which = argc > 2 ? argv[2] : "";
+        if (which.empty() || which == "rebuild") benchmarkRebuild();
+        if (which.empty() || which == "threshold") benchmarkThreshold();
+        if (which.empty() || which == "layout") benchmarkLayout();
+        if (which.empty() || which == "dary") benchmarkDary();
+        return 0;
+    }
+
+    PerfectBinaryHeap<> heap;
     heap.makeHeap();
+    heap.printLastOperation();
     
     // Insert elements to create the T4 example
     vector<int> elements = {5, 7, 10, 8, 18, 14, 12, 15, 21, 19, 17, 21, 25, 16, 18, 29};
     for (int elem : elements) {
         heap.insert(elem);
+        heap.printLastOperation();
     }
     
     cout << "Initial heap (T4 example):\n";
@@ -280,22 +764,27 @@ int main() {
     // Extract minimum (5) as shown in screenshot
     cout << "\nExtracting minimum...\n";
     int minVal = heap.extractMin();
+    heap.printLastOperation();
     cout << "Extracted: " << minVal << "\n";
     
     cout << "\nHeap after extraction:\n";
     heap.printHeap();
     
     // Demonstrate union operation
-    PerfectBinaryHeap heap2;
+    PerfectBinaryHeap<> heap2;
     heap2.insert(3);
+    heap2.printLastOperation();
     heap2.insert(9);
+    heap2.printLastOperation();
     
     cout << "\nSecond heap before union:\n";
     heap2.printHeap();
     
     heap.unionHeap(heap2);
+    heap.printLastOperation();
     cout << "\nMerged heap after union:\n";
     heap.printHeap();
     
     return 0;
 }
+#endif
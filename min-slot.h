@@ -0,0 +1,85 @@
+#ifndef MIN_SLOT_H
+#define MIN_SLOT_H
+
+#include <climits>
+#include <cstdint>
+#include <functional>
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+// Shared by BinomialHeap's root array and FibonacciHeap's consolidate
+// table.
+//
+// Slot of the smallest key among the occupied slots of keys[0..64), the
+// lowest slot on ties; occupied must be non-zero. Plain int keys under
+// std::less<int> take an AVX2 or SSE4.1 path when the build enables one
+// (-mavx2, -msse4.1 or -march=native). Unoccupied lanes are masked to
+// INT_MAX there, so callers only ever write the slots they fill.
+// Everything else walks the set bits.
+template <typename Key, typename Compare>
+int minSlot(const Key* keys, uint64_t occupied, const Compare& less) {
+    int best = __builtin_ctzll(occupied);
+    for (uint64_t m = occupied & (occupied - 1); m; m &= m - 1) {
+        int d = __builtin_ctzll(m);
+        if (less(keys[d], keys[best])) best = d;
+    }
+    return best;
+}
+
+#if defined(__AVX2__)
+inline int minSlot(const int* keys, uint64_t occupied, const std::less<int>&) {
+    int slots = 64 - __builtin_clzll(occupied);
+    const __m256i laneBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    const __m256i empty = _mm256_set1_epi32(INT_MAX);
+
+    // Occupied keys of the 8-slot block starting at i, INT_MAX elsewhere
+    auto block = [&](int i) {
+        __m256i bits = _mm256_set1_epi32((int)((occupied >> i) & 0xFF));
+        __m256i on = _mm256_cmpeq_epi32(_mm256_and_si256(bits, laneBits), laneBits);
+        __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+        return _mm256_blendv_epi8(empty, k, on);
+    };
+
+    __m256i lo = block(0);
+    for (int i = 8; i < slots; i += 8) lo = _mm256_min_epi32(lo, block(i));
+    __m128i v = _mm_min_epi32(_mm256_castsi256_si128(lo), _mm256_extracti128_si256(lo, 1));
+    v = _mm_min_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_min_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    __m256i target = _mm256_set1_epi32(_mm_cvtsi128_si32(v));
+
+    for (int i = 0;; i += 8) {
+        int hits = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(block(i), target)));
+        hits &= (int)((occupied >> i) & 0xFF);
+        if (hits) return i + __builtin_ctz(hits);
+    }
+}
+#elif defined(__SSE4_1__)
+inline int minSlot(const int* keys, uint64_t occupied, const std::less<int>&) {
+    int slots = 64 - __builtin_clzll(occupied);
+    const __m128i laneBits = _mm_setr_epi32(1, 2, 4, 8);
+    const __m128i empty = _mm_set1_epi32(INT_MAX);
+
+    // Occupied keys of the 4-slot block starting at i, INT_MAX elsewhere
+    auto block = [&](int i) {
+        __m128i bits = _mm_set1_epi32((int)((occupied >> i) & 0xF));
+        __m128i on = _mm_cmpeq_epi32(_mm_and_si128(bits, laneBits), laneBits);
+        __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i));
+        return _mm_blendv_epi8(empty, k, on);
+    };
+
+    __m128i v = block(0);
+    for (int i = 4; i < slots; i += 4) v = _mm_min_epi32(v, block(i));
+    v = _mm_min_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_min_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    __m128i target = _mm_set1_epi32(_mm_cvtsi128_si32(v));
+
+    for (int i = 0;; i += 4) {
+        int hits = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(block(i), target)));
+        hits &= (int)((occupied >> i) & 0xF);
+        if (hits) return i + __builtin_ctz(hits);
+    }
+}
+#endif
+
+#endif
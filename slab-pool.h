@@ -0,0 +1,166 @@
+#ifndef SLAB_POOL_H
+#define SLAB_POOL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+// Slab allocator for fixed-size heap nodes, shared by the heap programs.
+// Slabs start small and double up to MAX_SLAB items; released items are
+// chained through their own storage, so steady-state insert/extractMin
+// never goes back to malloc.
+//
+// allocate() constructs an item and release() destroys it. Slabs are
+// freed by reset() and the destructor without visiting any item, so an
+// owner whose items have destructors runs them on its live items first.
+template <typename T>
+class SlabPool {
+private:
+    struct Slab {
+        Slab* next;
+        int capacity;
+
+        T* items() { return reinterpret_cast<T*>(this + 1); }
+    };
+    static_assert(sizeof(Slab) % alignof(T) == 0, "slab header breaks item alignment");
+    static_assert(sizeof(T) >= sizeof(void*), "free list is threaded through the items");
+
+    static const int MIN_SLAB = 8;
+    static const int MAX_SLAB = 1024;
+
+    Slab* slabs = nullptr;      // Slabs in use, the one being carved first
+    Slab* lastSlab = nullptr;
+    Slab* spare = nullptr;      // Slabs handed back by reset()
+    int used = 0;               // Items carved from slabs->items()
+    void* freeList = nullptr;
+    void* lastFree = nullptr;
+
+    static void*& nextFree(void* item) { return *static_cast<void**>(item); }
+
+    void grow() {
+        Slab* slab = spare;
+        if (slab) {
+            spare = slab->next;
+        } else {
+            int capacity = slabs ? std::min(slabs->capacity * 2, (int)MAX_SLAB) : (int)MIN_SLAB;
+            slab = static_cast<Slab*>(::operator new(sizeof(Slab) + capacity * sizeof(T)));
+            slab->capacity = capacity;
+        }
+        slab->next = slabs;
+        if (!slabs) lastSlab = slab;
+        slabs = slab;
+        used = 0;
+    }
+
+    // Links a slab whose items are all handed out behind the one being
+    // carved, so carving carries on where it was
+    void addFullSlab(Slab* slab) {
+        if (!slabs) {
+            slab->next = nullptr;
+            slabs = lastSlab = slab;
+            used = slab->capacity;
+        } else {
+            slab->next = slabs->next;
+            slabs->next = slab;
+            if (lastSlab == slabs) lastSlab = slab;
+        }
+    }
+
+    static void freeSlabs(Slab* slab) {
+        while (slab) {
+            Slab* next = slab->next;
+            ::operator delete(slab);
+            slab = next;
+        }
+    }
+
+    static size_t slabBytes(const Slab* slab) {
+        size_t bytes = 0;
+        for (; slab; slab = slab->next) bytes += sizeof(Slab) + slab->capacity * sizeof(T);
+        return bytes;
+    }
+
+public:
+    SlabPool() {}
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    ~SlabPool() {
+        freeSlabs(slabs);
+        freeSlabs(spare);
+    }
+
+    template <typename... Args>
+    T* allocate(Args&&... args) {
+        void* item;
+        if (freeList) {
+            item = freeList;
+            freeList = nextFree(item);
+            if (!freeList) lastFree = nullptr;
+        } else {
+            if (!slabs || used == slabs->capacity) grow();
+            item = slabs->items() + used++;
+        }
+        return new (item) T(std::forward<Args>(args)...);
+    }
+
+    // Raw storage for n contiguous items in a slab of their own. The
+    // caller constructs them; they are released one by one as usual.
+    T* allocateBlock(int n) {
+        Slab* slab = static_cast<Slab*>(::operator new(sizeof(Slab) + n * sizeof(T)));
+        slab->capacity = n;
+        addFullSlab(slab);
+        return slab->items();
+    }
+
+    void release(T* item) {
+        item->~T();
+        nextFree(item) = freeList;
+        if (!freeList) lastFree = item;
+        freeList = item;
+    }
+
+    // Frees every item at once without visiting any of them
+    void reset() {
+        if (slabs) {
+            lastSlab->next = spare;
+            spare = slabs;
+        }
+        slabs = lastSlab = nullptr;
+        used = 0;
+        freeList = lastFree = nullptr;
+    }
+
+    // Takes over other's live slabs and free list in O(1), so items
+    // allocated there may be released here. Whatever other had left to
+    // carve in its current slab stays unused until reset().
+    void adopt(SlabPool& other) {
+        if (other.slabs) {
+            if (!slabs) {
+                slabs = other.slabs;
+                lastSlab = other.lastSlab;
+                used = other.used;
+            } else {
+                other.lastSlab->next = slabs->next;
+                slabs->next = other.slabs;
+                if (lastSlab == slabs) lastSlab = other.lastSlab;
+            }
+        }
+        if (other.freeList) {
+            nextFree(other.lastFree) = freeList;
+            if (!freeList) lastFree = other.lastFree;
+            freeList = other.freeList;
+        }
+        other.slabs = other.lastSlab = nullptr;
+        other.used = 0;
+        other.freeList = other.lastFree = nullptr;
+    }
+
+    // Bytes held in slabs, headers and spare slabs included
+    size_t bytes() const {
+        return slabBytes(slabs) + slabBytes(spare);
+    }
+};
+
+#endif